@@ -2,6 +2,7 @@
 //`define HSMC_HDMI
 `define VIP
 `define PIXPAR2
+//`define VIP_422     // sys.qsys must be switched with board/vip_422.tcl
 `define ENABLE_DDR2LP
 
 module C5G_vd_isl (
@@ -175,7 +176,7 @@ wire IR_RX_i = GPIO[34];
 wire pclk_capture = ISL_PCLK_i;
 wire SPDIF_EXT_i = SW[9];
 
-wire [15:0] sys_ctrl;
+wire [31:0] sys_ctrl;
 /*wire sys_poweron = sys_ctrl[0];
 wire isl_reset_n = sys_ctrl[1];
 wire hdmirx_reset_n = sys_ctrl[2];*/
@@ -191,6 +192,9 @@ wire isl_vsync_type = sys_ctrl[10];
 wire testpattern_enable = sys_ctrl[12];
 wire csc_enable = sys_ctrl[13];
 wire framelock = sys_ctrl[14];
+wire [2:0] stress_mode = sys_ctrl[28:26];
+wire [2:0] lm_prefetch_dist = sys_ctrl[31:29];
+wire [1:0] bfi_lit_frames = sys_ctrl[17:16];
 
 assign HDMI_TX_HSMC_RESET_N = sys_reset_n;
 
@@ -203,6 +207,7 @@ assign GPIO[4] = sda_oe ? 1'b0 : 1'bz;*/
 assign HDMI_I2C_SDA = sda_oe ? 1'b0 : 1'bz;*/
 
 reg ir_rx_sync1_reg, ir_rx_sync2_reg;
+reg hdmitx_int_n_sync1_reg, hdmitx_int_n_sync2_reg;
 reg [5:0] btn_sync1_reg, btn_sync2_reg;
 
 wire [15:0] ir_code;
@@ -223,11 +228,17 @@ wire [27:0] emif_rd_addr, emif_wr_addr;
 wire [255:0] emif_rd_rdata, emif_wr_wdata;
 wire [5:0] emif_rd_burstcount, emif_wr_burstcount;
 wire emif_rd_read, emif_rd_waitrequest, emif_rd_readdatavalid, emif_wr_write, emif_wr_waitrequest;
+wire [27:0] emif_sc_rd_addr, emif_sc_wr_addr;
+wire [255:0] emif_sc_rd_rdata, emif_sc_wr_wdata;
+wire [5:0] emif_sc_rd_burstcount, emif_sc_wr_burstcount;
+wire emif_sc_rd_read, emif_sc_rd_waitrequest, emif_sc_rd_readdatavalid, emif_sc_wr_write, emif_sc_wr_waitrequest;
 
 wire cvi_overflow, cvo_underflow;
+wire [7:0] cvi_overflow_cnt, cvo_underflow_cnt;
 
 wire [31:0] controls = {2'h0, btn_sync2_reg, ir_code_cnt, ir_code};
-wire [31:0] sys_status = {cvi_overflow, cvo_underflow, 25'h0, emif_pll_locked, emif_status_powerdn_ack, emif_status_cal_fail, emif_status_cal_success, emif_status_init_done};
+wire [31:0] controls_evt;
+wire [31:0] sys_status = {cvi_overflow, cvo_underflow, hdmitx_int_n_sync2_reg, cvi_overflow_cnt, cvo_underflow_cnt, 8'h0, emif_pll_locked, emif_status_powerdn_ack, emif_status_cal_fail, emif_status_cal_success, emif_status_init_done};
 
 wire [31:0] hv_in_config, hv_in_config2, hv_in_config3, hv_out_config, hv_out_config2, hv_out_config3, xy_out_config, xy_out_config2;
 wire [31:0] misc_config, sl_config, sl_config2, sl_config3;
@@ -323,9 +334,36 @@ isl51002_frontend u_isl_frontend (
     .pcnt_frame(ISL_fe_pcnt_frame)
 );
 
-wire [7:0] R_capt = ISL_R_post;
-wire [7:0] G_capt = ISL_G_post;
-wire [7:0] B_capt = ISL_B_post;
+wire [7:0] R_capt, G_capt, B_capt;
+stress_pattern_gen u_stress_pattern_gen (
+    .PCLK_i(pclk_capture),
+    .reset_n(sys_reset_n),
+    .mode(stress_mode),
+    .frame_change_i(ISL_fe_frame_change),
+    .datavalid_i(ISL_datavalid_post),
+    .xpos_i(ISL_fe_xpos),
+    .ypos_i(ISL_fe_ypos),
+    .R_i(ISL_R_post),
+    .G_i(ISL_G_post),
+    .B_i(ISL_B_post),
+    .R_o(R_capt),
+    .G_o(G_capt),
+    .B_o(B_capt)
+);
+
+pulse_counter u_cvi_overflow_ctr (
+    .CLK_i(clk27),
+    .reset_n(sys_reset_n),
+    .event_i(cvi_overflow),
+    .cnt_o(cvi_overflow_cnt)
+);
+
+pulse_counter u_cvo_underflow_ctr (
+    .CLK_i(clk27),
+    .reset_n(sys_reset_n),
+    .event_i(cvo_underflow),
+    .cnt_o(cvo_underflow_cnt)
+);
 wire HSYNC_capt = ISL_HSYNC_post;
 wire VSYNC_capt = ISL_VSYNC_post;
 wire DE_capt = ISL_DE_post;
@@ -421,6 +459,23 @@ always @(posedge pclk_capture_div2) begin
     dc_fifo_in_rdempty_prev <= dc_fifo_in_rdempty;
 end
 `endif // DIV2_SYNC
+
+// optional YCbCr 4:2:2 storage inside VIP to reduce DDR bandwidth
+`ifdef VIP_422
+wire [31:0] VIP_DATA_cvi, VIP_DATA_cvo;
+vip_422_pack u_vip_422_pack (
+    .rgb_i(VIP_DATA_i),
+    .ycbcr_o(VIP_DATA_cvi)
+);
+vip_422_unpack u_vip_422_unpack (
+    .ycbcr_i(VIP_DATA_cvo),
+    .rgb_o(VIP_DATA_o)
+);
+`else
+wire [47:0] VIP_DATA_cvi = VIP_DATA_i;
+wire [47:0] VIP_DATA_cvo;
+assign VIP_DATA_o = VIP_DATA_cvo;
+`endif
 `else // PIXPAR2
 wire [23:0] VIP_DATA_i = {R_capt, G_capt, B_capt};
 wire VIP_HSYNC_i = ~HSYNC_capt;
@@ -428,6 +483,9 @@ wire VIP_VSYNC_i = ~VSYNC_capt;
 wire VIP_DE_i = DE_capt & datavalid_capt;
 wire VIP_FID_i = ~FID_capt;
 wire [23:0] VIP_DATA_o;
+wire [23:0] VIP_DATA_cvi = VIP_DATA_i;
+wire [23:0] VIP_DATA_cvo;
+assign VIP_DATA_o = VIP_DATA_cvo;
 wire [7:0] R_vip = VIP_DATA_o[23:16];
 wire [7:0] G_vip = VIP_DATA_o[15:8];
 wire [7:0] B_vip = VIP_DATA_o[7:0];
@@ -450,6 +508,26 @@ reg [7:0] R_out, G_out, B_out;
 reg HSYNC_out, VSYNC_out, DE_out;
 wire [7:0] R_sc, G_sc, B_sc;
 wire HSYNC_sc, VSYNC_sc, DE_sc;
+wire [7:0] R_bfi, G_bfi, B_bfi;
+
+// deterministic BFI for frame multiplication modes
+bfi_sched #(
+    .YPOS_WIDTH(11)
+  ) u_bfi_sched (
+    .PCLK_CAP_i(pclk_capture),
+    .PCLK_OUT_i(pclk_out),
+    .reset_n(sys_reset_n),
+    .lit_frames_i(bfi_lit_frames),
+    .frame_change_i(frame_change_capt),
+    .ypos_i(ypos_sc),
+    .R_i(R_sc),
+    .G_i(G_sc),
+    .B_i(B_sc),
+    .R_o(R_bfi),
+    .G_o(G_bfi),
+    .B_o(B_bfi),
+    .frame_idx_o()
+);
 
 always @(posedge pclk_out) begin
     if (osd_enable) begin
@@ -463,7 +541,7 @@ always @(posedge pclk_out) begin
             {R_out, G_out, B_out} <= 24'hffffff;
         end
     end else begin
-        {R_out, G_out, B_out} <= {R_sc, G_sc, B_sc};
+        {R_out, G_out, B_out} <= {R_bfi, G_bfi, B_bfi};
     end
 
     HSYNC_out <= HSYNC_sc;
@@ -517,11 +595,15 @@ always @(posedge clk27 or negedge sys_reset_n) begin
         btn_sync2_reg <= '1;
         ir_rx_sync1_reg <= 1'b1;
         ir_rx_sync2_reg <= 1'b1;
+        hdmitx_int_n_sync1_reg <= 1'b1;
+        hdmitx_int_n_sync2_reg <= 1'b1;
     end else begin
         btn_sync1_reg <= {KEY, 2'h3};
         btn_sync2_reg <= btn_sync1_reg;
         ir_rx_sync1_reg <= IR_RX_i;
         ir_rx_sync2_reg <= ir_rx_sync1_reg;
+        hdmitx_int_n_sync1_reg <= HDMI_TX_INT;
+        hdmitx_int_n_sync2_reg <= hdmitx_int_n_sync1_reg;
     end
 end
 
@@ -576,7 +658,9 @@ sys sys_inst (
     .i2c_opencores_2_export_sda_pad_io      (HDMI_TX_HSMC_I2C_SDA),
     .i2c_opencores_2_export_spi_miso_pad_i  (1'b0),
     .pio_0_sys_ctrl_out_export              (sys_ctrl),
-    .pio_1_controls_in_export               (controls),
+    .pio_1_controls_in_export               (controls_evt),
+    .ctrl_event_fifo_0_ctrl_controls_i      (controls),
+    .ctrl_event_fifo_0_ctrl_controls_o      (controls_evt),
     .pio_2_sys_status_in_export             (sys_status),
     .sc_config_0_sc_if_fe_status_i          ({20'h0, ISL_fe_interlace, ISL_fe_vtotal}),
     .sc_config_0_sc_if_fe_status2_i         ({12'h0, ISL_fe_pcnt_frame}),
@@ -639,7 +723,7 @@ sys sys_inst (
     pclk_capture
 `endif
     ),
-    .alt_vip_cl_cvi_0_clocked_video_vid_data                   (VIP_DATA_i),
+    .alt_vip_cl_cvi_0_clocked_video_vid_data                   (VIP_DATA_cvi),
     .alt_vip_cl_cvi_0_clocked_video_vid_de                     (VIP_DE_i),
     .alt_vip_cl_cvi_0_clocked_video_vid_datavalid              (!dc_fifo_in_rdempty_prev),
     .alt_vip_cl_cvi_0_clocked_video_vid_locked                 (1'b1),
@@ -661,7 +745,7 @@ sys sys_inst (
     pclk_out
 `endif
     ),
-    .alt_vip_cl_cvo_0_clocked_video_vid_data                   (VIP_DATA_o),
+    .alt_vip_cl_cvo_0_clocked_video_vid_data                   (VIP_DATA_cvo),
     .alt_vip_cl_cvo_0_clocked_video_underflow                  (cvo_underflow),
     .alt_vip_cl_cvo_0_clocked_video_vid_mode_change            (),
     .alt_vip_cl_cvo_0_clocked_video_vid_std                    (),
@@ -733,17 +817,45 @@ scanconverter #(
     .ypos_o(ypos_sc),
     .resync_strobe(resync_strobe_i),
     .emif_br_clk(emif_br_clk),
-    .emif_rd_addr(emif_rd_addr),
-    .emif_rd_read(emif_rd_read),
-    .emif_rd_rdata(emif_rd_rdata),
-    .emif_rd_waitrequest(emif_rd_waitrequest),
-    .emif_rd_readdatavalid(emif_rd_readdatavalid),
-    .emif_rd_burstcount(emif_rd_burstcount),
-    .emif_wr_addr(emif_wr_addr),
-    .emif_wr_write(emif_wr_write),
-    .emif_wr_wdata(emif_wr_wdata),
-    .emif_wr_waitrequest(emif_wr_waitrequest),
-    .emif_wr_burstcount(emif_wr_burstcount)
+    .emif_rd_addr(emif_sc_rd_addr),
+    .emif_rd_read(emif_sc_rd_read),
+    .emif_rd_rdata(emif_sc_rd_rdata),
+    .emif_rd_waitrequest(emif_sc_rd_waitrequest),
+    .emif_rd_readdatavalid(emif_sc_rd_readdatavalid),
+    .emif_rd_burstcount(emif_sc_rd_burstcount),
+    .emif_wr_addr(emif_sc_wr_addr),
+    .emif_wr_write(emif_sc_wr_write),
+    .emif_wr_wdata(emif_sc_wr_wdata),
+    .emif_wr_waitrequest(emif_sc_wr_waitrequest),
+    .emif_wr_burstcount(emif_sc_wr_burstcount)
+);
+
+emif_sched emif_sched0 (
+    .clk(emif_br_clk),
+    .reset_n(emif_mpfe_reset_n),
+    .pf_dist_i(lm_prefetch_dist),
+    .us_rd_addr(emif_sc_rd_addr),
+    .us_rd_read(emif_sc_rd_read),
+    .us_rd_rdata(emif_sc_rd_rdata),
+    .us_rd_waitrequest(emif_sc_rd_waitrequest),
+    .us_rd_readdatavalid(emif_sc_rd_readdatavalid),
+    .us_rd_burstcount(emif_sc_rd_burstcount),
+    .us_wr_addr(emif_sc_wr_addr),
+    .us_wr_write(emif_sc_wr_write),
+    .us_wr_wdata(emif_sc_wr_wdata),
+    .us_wr_waitrequest(emif_sc_wr_waitrequest),
+    .us_wr_burstcount(emif_sc_wr_burstcount),
+    .dn_rd_addr(emif_rd_addr),
+    .dn_rd_read(emif_rd_read),
+    .dn_rd_rdata(emif_rd_rdata),
+    .dn_rd_waitrequest(emif_rd_waitrequest),
+    .dn_rd_readdatavalid(emif_rd_readdatavalid),
+    .dn_rd_burstcount(emif_rd_burstcount),
+    .dn_wr_addr(emif_wr_addr),
+    .dn_wr_write(emif_wr_write),
+    .dn_wr_wdata(emif_wr_wdata),
+    .dn_wr_waitrequest(emif_wr_waitrequest),
+    .dn_wr_burstcount(emif_wr_burstcount)
 );
 
 ir_rcv ir0 (
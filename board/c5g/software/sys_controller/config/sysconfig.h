@@ -8,6 +8,24 @@
 //#define INC_SII1136
 #define INC_ADV7513
 #define VIP
+//#define VIP_422  // must match top-level RTL and sys.qsys (board/vip_422.tcl)
+
+// VFB buffer placement (sys.qsys) and DDR window of SD controller DMA master for frame capture
+#define FB_CAPTURE_DDR_WINDOW   0x40000000
+#define VFB_MEM_BASE            0x00000000
+#define VFB_BUF_OFFSET          0x08000000
+
+// Max frame multiplication factor for LM modes (frame repeat from EMIF linebuffer)
+#define FRAME_MULT_MAX          4
+
+// EPCQ256 4KB subsector erase for in-firmware update from SD (fw_update.c)
+#define FW_UPDATE_BOARD_ID      FW_UPDATE_BOARD_C5G
+#define FW_UPDATE_ERASE_SIZE    4096
+#define FW_UPDATE_ERASE_OPCODE  0x20
+
+// On-chip RAM freed by sharing transient buffers in scratch arena (scratch.c) goes to
+// generated scaler coefficient sets. Check sys_controller.memmap after changing.
+#define SCL_GEN_CACHE_SIZE      6
 
 #ifndef DEBUG
 #define OS_PRINTF(...)
@@ -7,8 +7,21 @@
 #define DE10N
 #define INC_ADV7513
 #define VIP
+//#define VIP_422  // must match top-level RTL and sys.qsys (board/vip_422.tcl)
+
+// VFB buffer placement (sys.qsys) and DDR window of SD controller DMA master for frame capture
+#define FB_CAPTURE_DDR_WINDOW   0x40000000
+#define VFB_MEM_BASE            0x10000000
+#define VFB_BUF_OFFSET          0x08000000
 #define LM_EMIF_EXTRA_DELAY
 
+// Max frame multiplication factor for LM modes (frame repeat from EMIF linebuffer)
+#define FRAME_MULT_MAX          4
+
+// LM EMIF bandwidth/latency counters (rtl_extra/emif_perf_mon.v) muxed into sys_status[12:0]
+#define EMIF_PERF_MON
+#define EMIF_PERF_CLK_MHZ       100
+
 #if ALT_VIP_CL_DIL_0_SPAN == 256
 #define VIP_DIL_B
 #elif ALT_VIP_CL_DIL_0_SPAN == 128
@@ -103,7 +103,7 @@ wire ISL_INT_N_i = GPIO[33];
 wire pclk_capture = ISL_PCLK_i;
 wire SPDIF_EXT_i = EX_IO[3];
 
-wire [15:0] sys_ctrl;
+wire [31:0] sys_ctrl;
 /*wire sys_poweron = sys_ctrl[0];
 wire isl_reset_n = sys_ctrl[1];
 wire hdmirx_reset_n = sys_ctrl[2];
@@ -119,6 +119,8 @@ wire isl_vsync_type = sys_ctrl[10];
 wire testpattern_enable = sys_ctrl[12];
 wire csc_enable = sys_ctrl[13];
 wire framelock = sys_ctrl[14];
+wire [2:0] stress_mode = sys_ctrl[28:26];
+wire [2:0] lm_prefetch_dist = sys_ctrl[31:29];
 
 assign HDMI_TX_HSMC_RESET_N = sys_reset_n;
 
@@ -143,17 +145,27 @@ wire nios_reset_req;
 
 wire pll_locked, emif_pll_locked;
 
-/* EMIF IF for LM */
+/* EMIF IF for LM (32-bit SDRAM port, width converted by emif_sdr_adapter) */
 wire emif_br_clk;
-wire [27:0] emif_rd_addr, emif_wr_addr;
-wire [255:0] emif_rd_rdata, emif_wr_wdata;
+wire [31:0] emif_rd_addr, emif_wr_addr;
+wire [31:0] emif_rd_rdata, emif_wr_wdata;
 wire [5:0] emif_rd_burstcount, emif_wr_burstcount;
 wire emif_rd_read, emif_rd_waitrequest, emif_rd_readdatavalid, emif_wr_write, emif_wr_waitrequest;
+wire [27:0] emif_lm_rd_addr, emif_lm_wr_addr;
+wire [255:0] emif_lm_rd_rdata, emif_lm_wr_wdata;
+wire [5:0] emif_lm_rd_burstcount, emif_lm_wr_burstcount;
+wire emif_lm_rd_read, emif_lm_rd_waitrequest, emif_lm_rd_readdatavalid, emif_lm_wr_write, emif_lm_wr_waitrequest;
+wire [27:0] emif_sc_rd_addr, emif_sc_wr_addr;
+wire [255:0] emif_sc_rd_rdata, emif_sc_wr_wdata;
+wire [5:0] emif_sc_rd_burstcount, emif_sc_wr_burstcount;
+wire emif_sc_rd_read, emif_sc_rd_waitrequest, emif_sc_rd_readdatavalid, emif_sc_wr_write, emif_sc_wr_waitrequest;
 
 wire cvi_overflow, cvo_underflow;
+wire [7:0] cvi_overflow_cnt, cvo_underflow_cnt;
 
 wire [31:0] controls = {2'h0, btn_sync2_reg, ir_code_cnt, ir_code};
-wire [31:0] sys_status = {32'h0};
+wire [31:0] controls_evt;
+wire [31:0] sys_status = {cvi_overflow, cvo_underflow, 1'b0, cvi_overflow_cnt, cvo_underflow_cnt, 13'h0};
 
 wire [31:0] hv_in_config, hv_in_config2, hv_in_config3, hv_out_config, hv_out_config2, hv_out_config3, xy_out_config, xy_out_config2;
 wire [31:0] misc_config, sl_config, sl_config2, sl_config3;
@@ -247,9 +259,36 @@ isl51002_frontend u_isl_frontend (
     .pcnt_frame(ISL_fe_pcnt_frame)
 );
 
-wire [7:0] R_capt = ISL_R_post;
-wire [7:0] G_capt = ISL_G_post;
-wire [7:0] B_capt = ISL_B_post;
+wire [7:0] R_capt, G_capt, B_capt;
+stress_pattern_gen u_stress_pattern_gen (
+    .PCLK_i(pclk_capture),
+    .reset_n(sys_reset_n),
+    .mode(stress_mode),
+    .frame_change_i(ISL_fe_frame_change),
+    .datavalid_i(ISL_datavalid_post),
+    .xpos_i(ISL_fe_xpos),
+    .ypos_i(ISL_fe_ypos),
+    .R_i(ISL_R_post),
+    .G_i(ISL_G_post),
+    .B_i(ISL_B_post),
+    .R_o(R_capt),
+    .G_o(G_capt),
+    .B_o(B_capt)
+);
+
+pulse_counter u_cvi_overflow_ctr (
+    .CLK_i(clk27),
+    .reset_n(sys_reset_n),
+    .event_i(cvi_overflow),
+    .cnt_o(cvi_overflow_cnt)
+);
+
+pulse_counter u_cvo_underflow_ctr (
+    .CLK_i(clk27),
+    .reset_n(sys_reset_n),
+    .event_i(cvo_underflow),
+    .cnt_o(cvo_underflow_cnt)
+);
 wire HSYNC_capt = ISL_HSYNC_post;
 wire VSYNC_capt = ISL_VSYNC_post;
 wire DE_capt = ISL_DE_post;
@@ -487,7 +526,9 @@ sys sys_inst (
     .i2c_opencores_1_export_sda_pad_io      (HDMI_TX_HSMC_I2C_SDA),
     .i2c_opencores_1_export_spi_miso_pad_i  (1'b0),
     .pio_0_sys_ctrl_out_export              (sys_ctrl),
-    .pio_1_controls_in_export               (controls),
+    .pio_1_controls_in_export               (controls_evt),
+    .ctrl_event_fifo_0_ctrl_controls_i      (controls),
+    .ctrl_event_fifo_0_ctrl_controls_o      (controls_evt),
     .sc_config_0_sc_if_fe_status_i          ({20'h0, ISL_fe_interlace, ISL_fe_vtotal}),
     .sc_config_0_sc_if_fe_status2_i         ({12'h0, ISL_fe_pcnt_frame}),
     .sc_config_0_sc_if_lt_status_i          (32'h00000000),
@@ -515,12 +556,12 @@ sys sys_inst (
     .character_lcd_0_external_interface_RS  (LCD_RS),
     .character_lcd_0_external_interface_RW  (LCD_RW),
     .emif_bridge_0_clk_o                    (emif_br_clk),
-    .emif_bridge_0_wr_address               ({4'h0, emif_wr_addr}),
+    .emif_bridge_0_wr_address               (emif_wr_addr),
     .emif_bridge_0_wr_write                 (emif_wr_write),
     .emif_bridge_0_wr_write_data            (emif_wr_wdata),
     .emif_bridge_0_wr_waitrequest           (emif_wr_waitrequest),
     .emif_bridge_0_wr_burstcount            (emif_wr_burstcount),
-    .emif_bridge_0_rd_address               ({4'h0, emif_rd_addr}),
+    .emif_bridge_0_rd_address               (emif_rd_addr),
     .emif_bridge_0_rd_read                  (emif_rd_read),
     .emif_bridge_0_rd_read_data             (emif_rd_rdata),
     .emif_bridge_0_rd_waitrequest           (emif_rd_waitrequest),
@@ -585,8 +626,8 @@ sys sys_inst (
 );
 
 scanconverter #(
-    .EMIF_ENABLE(0),
-    .NUM_LINE_BUFFERS(32)
+    .EMIF_ENABLE(1),
+    .NUM_LINE_BUFFERS(2048)
   ) scanconverter_inst (
     .PCLK_CAP_i(pclk_capture),
     .PCLK_OUT_i(SI_PCLK_i),
@@ -638,17 +679,78 @@ scanconverter #(
     .ypos_o(ypos_sc),
     .resync_strobe(resync_strobe_i),
     .emif_br_clk(emif_br_clk),
-    .emif_rd_addr(emif_rd_addr),
-    .emif_rd_read(emif_rd_read),
-    .emif_rd_rdata(emif_rd_rdata),
-    .emif_rd_waitrequest(emif_rd_waitrequest),
-    .emif_rd_readdatavalid(emif_rd_readdatavalid),
-    .emif_rd_burstcount(emif_rd_burstcount),
-    .emif_wr_addr(emif_wr_addr),
-    .emif_wr_write(emif_wr_write),
-    .emif_wr_wdata(emif_wr_wdata),
-    .emif_wr_waitrequest(emif_wr_waitrequest),
-    .emif_wr_burstcount(emif_wr_burstcount)
+    .emif_rd_addr(emif_sc_rd_addr),
+    .emif_rd_read(emif_sc_rd_read),
+    .emif_rd_rdata(emif_sc_rd_rdata),
+    .emif_rd_waitrequest(emif_sc_rd_waitrequest),
+    .emif_rd_readdatavalid(emif_sc_rd_readdatavalid),
+    .emif_rd_burstcount(emif_sc_rd_burstcount),
+    .emif_wr_addr(emif_sc_wr_addr),
+    .emif_wr_write(emif_sc_wr_write),
+    .emif_wr_wdata(emif_sc_wr_wdata),
+    .emif_wr_waitrequest(emif_sc_wr_waitrequest),
+    .emif_wr_burstcount(emif_sc_wr_burstcount)
+);
+
+emif_sched emif_sched0 (
+    .clk(emif_br_clk),
+    .reset_n(vip_reset_n),
+    .pf_dist_i(lm_prefetch_dist),
+    .us_rd_addr(emif_sc_rd_addr),
+    .us_rd_read(emif_sc_rd_read),
+    .us_rd_rdata(emif_sc_rd_rdata),
+    .us_rd_waitrequest(emif_sc_rd_waitrequest),
+    .us_rd_readdatavalid(emif_sc_rd_readdatavalid),
+    .us_rd_burstcount(emif_sc_rd_burstcount),
+    .us_wr_addr(emif_sc_wr_addr),
+    .us_wr_write(emif_sc_wr_write),
+    .us_wr_wdata(emif_sc_wr_wdata),
+    .us_wr_waitrequest(emif_sc_wr_waitrequest),
+    .us_wr_burstcount(emif_sc_wr_burstcount),
+    .dn_rd_addr(emif_lm_rd_addr),
+    .dn_rd_read(emif_lm_rd_read),
+    .dn_rd_rdata(emif_lm_rd_rdata),
+    .dn_rd_waitrequest(emif_lm_rd_waitrequest),
+    .dn_rd_readdatavalid(emif_lm_rd_readdatavalid),
+    .dn_rd_burstcount(emif_lm_rd_burstcount),
+    .dn_wr_addr(emif_lm_wr_addr),
+    .dn_wr_write(emif_lm_wr_write),
+    .dn_wr_wdata(emif_lm_wr_wdata),
+    .dn_wr_waitrequest(emif_lm_wr_waitrequest),
+    .dn_wr_burstcount(emif_lm_wr_burstcount)
+);
+
+// LM window in upper 64MB of SDRAM (bank pair 2/3), VIP DIL/VFB buffers reside in lower half.
+// SDRAM controller maps {bank[1] [26], row [25:13], bank[0] [12], column [11:2]}, so LM rows
+// alternate between banks 2 and 3 every 4KB.
+emif_sdr_adapter #(
+    .LM_BASE(32'h04000000),
+    .WIN_AW(26)
+) emif_sdr_adapter0 (
+    .clk(emif_br_clk),
+    .reset_n(vip_reset_n),
+    .us_rd_addr(emif_lm_rd_addr),
+    .us_rd_read(emif_lm_rd_read),
+    .us_rd_rdata(emif_lm_rd_rdata),
+    .us_rd_waitrequest(emif_lm_rd_waitrequest),
+    .us_rd_readdatavalid(emif_lm_rd_readdatavalid),
+    .us_rd_burstcount(emif_lm_rd_burstcount),
+    .us_wr_addr(emif_lm_wr_addr),
+    .us_wr_write(emif_lm_wr_write),
+    .us_wr_wdata(emif_lm_wr_wdata),
+    .us_wr_waitrequest(emif_lm_wr_waitrequest),
+    .us_wr_burstcount(emif_lm_wr_burstcount),
+    .dn_rd_addr(emif_rd_addr),
+    .dn_rd_read(emif_rd_read),
+    .dn_rd_rdata(emif_rd_rdata),
+    .dn_rd_waitrequest(emif_rd_waitrequest),
+    .dn_rd_readdatavalid(emif_rd_readdatavalid),
+    .dn_rd_burstcount(emif_rd_burstcount),
+    .dn_wr_addr(emif_wr_addr),
+    .dn_wr_write(emif_wr_write),
+    .dn_wr_wdata(emif_wr_wdata),
+    .dn_wr_waitrequest(emif_wr_waitrequest),
+    .dn_wr_burstcount(emif_wr_burstcount)
 );
 
 ir_rcv ir0 (
@@ -9,6 +9,14 @@
 #define INC_SII1136
 #define VIP
 
+// EPCS64 has 64KB sector erase only (fw_update.c)
+#define FW_UPDATE_BOARD_ID      FW_UPDATE_BOARD_DE2_115
+#define FW_UPDATE_ERASE_SIZE    65536
+#define FW_UPDATE_ERASE_OPCODE  0xd8
+
+// One extra scaler coefficient set fits in RAM left over by scratch arena (sys_controller.memmap)
+#define SCL_GEN_CACHE_SIZE      5
+
 #ifndef DEBUG
 #define OS_PRINTF(...)
 #define ErrorF(...)
@@ -0,0 +1,59 @@
+#
+# Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+#
+# This file is part of Open Source Scan Converter project.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+
+# Switches VIP cores of a board's sys.qsys between RGB 4:4:4 (3 color planes) and YCbCr 4:2:2
+# (2 color planes) storage. Run from board directory (c5g or de10-nano), e.g.
+#
+#   qsys-script --system-file=sys.qsys --script=../vip_422.tcl --cmd="set vip_422 1"
+#
+# and regenerate the system. VIP_422 define in top-level RTL and sysconfig.h must match.
+
+package require -exact qsys 16.1
+
+if {![info exists vip_422]} {
+    set vip_422 1
+}
+set vip_422 [expr {$vip_422 ? 1 : 0}]
+set planes [expr {$vip_422 ? 2 : 3}]
+
+foreach inst [get_instances] {
+    switch [get_instance_property $inst CLASS_NAME] {
+        alt_vip_cl_cvi -
+        alt_vip_cl_cvo {
+            set_instance_parameter_value $inst NUMBER_OF_COLOUR_PLANES $planes
+        }
+        alt_vip_cl_dil {
+            set_instance_parameter_value $inst NUMBER_OF_COLOR_PLANES $planes
+            set_instance_parameter_value $inst INCOMING_VIDEO_IS_422 $vip_422
+        }
+        alt_vip_cl_vfb -
+        alt_vip_cl_interlacer {
+            set_instance_parameter_value $inst NUMBER_OF_COLOR_PLANES $planes
+        }
+        alt_vip_cl_scl {
+            set_instance_parameter_value $inst SYMBOLS_IN_PAR $planes
+            set_instance_parameter_value $inst IS_422 $vip_422
+        }
+        vip_st_monitor {
+            set_instance_parameter_value $inst SYMBOLS_PER_BEAT [expr {$planes*[get_instance_parameter_value $inst PIXELS_IN_PARALLEL]}]
+        }
+    }
+}
+
+save_system
@@ -0,0 +1,177 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+// Timestamped event FIFO for IR receiver and button inputs. controls_i carries the live
+// pio_1 word {2'h0, btn[5:0], ir_code_cnt[7:0], ir_code[15:0]}. A new IR frame (change of
+// ir_code_cnt) or a debounced button state change pushes an event with a microsecond timestamp.
+// controls_o is either the live word or a firmware written override word which is used to
+// replay events through the existing pio_1 interface. Override expires OVR_TIMEOUT_US after
+// last write so that firmware polling controls outside main loop still sees live inputs. Events
+// queued after expiry timestamp have then already been seen live and must not be replayed.
+//
+// Registers:
+//   0 CTRL    R: [5:0] level, [8] overflow, [9] override expired, [16] irq_en, [17] ovr_en
+//             W: [8] clear overflow, [9] clear expired, [16] irq_en, [17] ovr_en
+//   1 EVT_TS  R: timestamp of oldest event (us)
+//   2 EVT     R: oldest event, popped on read: [31:30] src (1=IR, 2=btn), [29:0] controls word
+//   3 TIME    R: current timestamp (us)
+//   4 OVR     R/W: override controls word, write refreshes override timeout
+//   5 EXP_TS  R: timestamp of last override expiry (us)
+
+module ctrl_event_fifo #(
+    parameter CLK_FREQ_MHZ = 27,
+    parameter DEPTH_LOG2 = 5,
+    parameter DEBOUNCE_US = 10000,
+    parameter OVR_TIMEOUT_US = 200000
+  ) (
+    input clk,
+    input reset,
+    input [2:0] avalon_s_address,
+    input avalon_s_read,
+    output reg [31:0] avalon_s_readdata,
+    input avalon_s_write,
+    input [31:0] avalon_s_writedata,
+    output irq,
+    input [31:0] controls_i,
+    output [31:0] controls_o
+);
+
+localparam SRC_IR = 2'h1;
+localparam SRC_BTN = 2'h2;
+
+localparam REG_CTRL = 3'h0;
+localparam REG_EVT_TS = 3'h1;
+localparam REG_EVT = 3'h2;
+localparam REG_TIME = 3'h3;
+localparam REG_OVR = 3'h4;
+localparam REG_EXP_TS = 3'h5;
+
+reg [31:0] fifo_data [0:(1<<DEPTH_LOG2)-1];
+reg [31:0] fifo_ts [0:(1<<DEPTH_LOG2)-1];
+reg [DEPTH_LOG2-1:0] wr_ptr, rd_ptr;
+reg [DEPTH_LOG2:0] level;
+reg overflow, ovr_expired, irq_en, ovr_en;
+
+reg [4:0] us_div;
+reg [31:0] time_us;
+reg [19:0] ovr_timer;
+reg [31:0] ovr_word, exp_ts;
+
+reg [7:0] ir_cnt_prev;
+reg [5:0] btn_stable, btn_prev;
+reg [15:0] btn_db_timer;
+
+wire us_tick = (us_div == CLK_FREQ_MHZ-1);
+wire ir_evt = (controls_i[23:16] != ir_cnt_prev) & (controls_i[23:16] != 0);
+wire btn_evt = us_tick & ~ir_evt & (btn_db_timer == DEBOUNCE_US) & (btn_prev != btn_stable);
+wire push = ir_evt | btn_evt;
+wire pop = avalon_s_read & (avalon_s_address == REG_EVT) & (level != 0);
+wire full = (level == (1<<DEPTH_LOG2));
+
+assign irq = irq_en & (level != 0);
+assign controls_o = (ovr_en & (ovr_timer != 0)) ? ovr_word : controls_i;
+
+always @(posedge clk) begin
+    if (push & ~full) begin
+        fifo_data[wr_ptr] <= {(ir_evt ? SRC_IR : SRC_BTN), (ir_evt ? btn_stable : btn_prev), controls_i[23:0]};
+        fifo_ts[wr_ptr] <= time_us;
+    end
+end
+
+always @(posedge clk or posedge reset) begin
+    if (reset) begin
+        wr_ptr <= 0;
+        rd_ptr <= 0;
+        level <= 0;
+        overflow <= 1'b0;
+        ovr_expired <= 1'b0;
+        irq_en <= 1'b0;
+        ovr_en <= 1'b0;
+        us_div <= 0;
+        time_us <= 0;
+        ovr_timer <= 0;
+        ovr_word <= 0;
+        exp_ts <= 0;
+        ir_cnt_prev <= 0;
+        btn_stable <= 6'h3f;
+        btn_prev <= 6'h3f;
+        btn_db_timer <= 0;
+        avalon_s_readdata <= 0;
+    end else begin
+        if (us_tick) begin
+            us_div <= 0;
+            time_us <= time_us + 1'b1;
+        end else begin
+            us_div <= us_div + 1'b1;
+        end
+
+        // button state is accepted after it has been stable for DEBOUNCE_US
+        ir_cnt_prev <= controls_i[23:16];
+        if (controls_i[29:24] != btn_prev) begin
+            btn_prev <= controls_i[29:24];
+            btn_db_timer <= 0;
+        end else if (us_tick && (btn_db_timer != DEBOUNCE_US)) begin
+            btn_db_timer <= btn_db_timer + 1'b1;
+        end
+        if (btn_evt)
+            btn_stable <= btn_prev;
+
+        if (push & ~full) begin
+            wr_ptr <= wr_ptr + 1'b1;
+        end else if (push) begin
+            overflow <= 1'b1;
+        end
+        if (pop)
+            rd_ptr <= rd_ptr + 1'b1;
+        level <= level + (push & ~full) - pop;
+
+        if (avalon_s_write && (avalon_s_address == REG_OVR)) begin
+            ovr_word <= avalon_s_writedata;
+            ovr_timer <= OVR_TIMEOUT_US;
+        end else if (us_tick && (ovr_timer != 0)) begin
+            ovr_timer <= ovr_timer - 1'b1;
+            if (ovr_en && (ovr_timer == 1)) begin
+                ovr_expired <= 1'b1;
+                exp_ts <= time_us;
+            end
+        end
+
+        if (avalon_s_write && (avalon_s_address == REG_CTRL)) begin
+            if (avalon_s_writedata[8])
+                overflow <= 1'b0;
+            if (avalon_s_writedata[9])
+                ovr_expired <= 1'b0;
+            irq_en <= avalon_s_writedata[16];
+            ovr_en <= avalon_s_writedata[17];
+        end
+
+        case (avalon_s_address)
+            REG_CTRL:   avalon_s_readdata <= {14'h0, ovr_en, irq_en, 6'h0, ovr_expired, overflow, {(7-DEPTH_LOG2){1'b0}}, level};
+            REG_EVT_TS: avalon_s_readdata <= fifo_ts[rd_ptr];
+            REG_EVT:    avalon_s_readdata <= (level != 0) ? fifo_data[rd_ptr] : 32'h0;
+            REG_TIME:   avalon_s_readdata <= time_us;
+            REG_OVR:    avalon_s_readdata <= ovr_word;
+            REG_EXP_TS: avalon_s_readdata <= exp_ts;
+            default:    avalon_s_readdata <= 32'h0;
+        endcase
+    end
+end
+
+endmodule
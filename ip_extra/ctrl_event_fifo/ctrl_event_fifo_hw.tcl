@@ -0,0 +1,82 @@
+#
+# Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+#
+# This file is part of Open Source Scan Converter project.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+
+package require -exact qsys 16.1
+
+set_module_property DESCRIPTION "IR/button event FIFO"
+set_module_property NAME ctrl_event_fifo
+set_module_property VERSION 1.0
+set_module_property INTERNAL false
+set_module_property OPAQUE_ADDRESS_MAP true
+set_module_property GROUP "Other"
+set_module_property AUTHOR "Markus Hiienkari"
+set_module_property DISPLAY_NAME ctrl_event_fifo
+set_module_property INSTANTIATE_IN_SYSTEM_MODULE true
+set_module_property EDITABLE true
+set_module_property REPORT_TO_TALKBACK false
+set_module_property ALLOW_GREYBOX_GENERATION false
+set_module_property REPORT_HIERARCHY false
+
+add_fileset QUARTUS_SYNTH QUARTUS_SYNTH "" ""
+set_fileset_property QUARTUS_SYNTH TOP_LEVEL ctrl_event_fifo
+set_fileset_property QUARTUS_SYNTH ENABLE_RELATIVE_INCLUDE_PATHS false
+set_fileset_property QUARTUS_SYNTH ENABLE_FILE_OVERWRITE_MODE false
+add_fileset_file ctrl_event_fifo.v VERILOG PATH ctrl_event_fifo.v TOP_LEVEL_FILE
+
+add_parameter CLK_FREQ_MHZ INTEGER 27
+set_parameter_property CLK_FREQ_MHZ DISPLAY_NAME "Clock frequency (MHz)"
+set_parameter_property CLK_FREQ_MHZ HDL_PARAMETER true
+add_parameter DEPTH_LOG2 INTEGER 5
+set_parameter_property DEPTH_LOG2 DISPLAY_NAME "FIFO depth (log2)"
+set_parameter_property DEPTH_LOG2 ALLOWED_RANGES 2:6
+set_parameter_property DEPTH_LOG2 HDL_PARAMETER true
+
+add_interface clock clock end
+set_interface_property clock clockRate 0
+add_interface_port clock clk clk Input 1
+
+add_interface reset reset end
+set_interface_property reset associatedClock clock
+set_interface_property reset synchronousEdges DEASSERT
+add_interface_port reset reset reset Input 1
+
+add_interface avalon_s avalon end
+set_interface_property avalon_s addressUnits WORDS
+set_interface_property avalon_s associatedClock clock
+set_interface_property avalon_s associatedReset reset
+set_interface_property avalon_s readLatency 1
+set_interface_property avalon_s readWaitTime 0
+set_interface_property avalon_s writeWaitTime 0
+set_interface_property avalon_s maximumPendingReadTransactions 0
+add_interface_port avalon_s avalon_s_address address Input 3
+add_interface_port avalon_s avalon_s_read read Input 1
+add_interface_port avalon_s avalon_s_readdata readdata Output 32
+add_interface_port avalon_s avalon_s_write write Input 1
+add_interface_port avalon_s avalon_s_writedata writedata Input 32
+
+add_interface irq interrupt end
+set_interface_property irq associatedAddressablePoint avalon_s
+set_interface_property irq associatedClock clock
+set_interface_property irq associatedReset reset
+add_interface_port irq irq irq Output 1
+
+add_interface ctrl conduit end
+set_interface_property ctrl associatedClock clock
+add_interface_port ctrl controls_i controls_i Input 32
+add_interface_port ctrl controls_o controls_o Output 32
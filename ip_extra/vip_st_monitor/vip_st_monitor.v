@@ -0,0 +1,270 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+// Stall monitor for the Avalon-ST Video links between VIP cores. Each link i is passed through
+// unchanged and its consumer core i is watched: if the core keeps ready low in the middle of a
+// packet for longer than TIMEOUT_US[i], it has stopped accepting data. Unless a link further
+// downstream is stalled as well (stall propagating from there), the core is reset through
+// core_reset_i for RESET_CYCLES, its input link is drained up to the next control packet and a
+// packet left open on its output link is terminated with a dummy end-of-packet beat. Recovery of
+// core i sets RECOVERED[i] which disables further automatic resets of the same core until firmware
+// has restored its registers and cleared the flag.
+//
+// Link/core order: 0 = CVI->DIL, 1 = DIL->VFB, 2 = VFB->SCL, 3 = SCL->CVO (or interlacer)
+//
+// Registers:
+//   0 CTRL      R/W: [3:0] automatic reset enable per core
+//   1 STATUS    R: [3:0] link stalled (mid-packet, ready low), [7:4] core in reset, [11:8] recovered,
+//                  [15:12] link inside packet
+//               W: [11:8] clear recovered
+//   2 FORCE     W: [3:0] reset core and flush its links immediately
+//   4-7 TIMEOUT R/W: stall timeout for link 0-3 in us (0 = disabled)
+//   8-11 STALLS R: stall events detected on link 0-3, W: clear
+
+module vip_st_monitor #(
+    parameter CLK_FREQ_MHZ = 148,
+    parameter DATA_WIDTH = 48,
+    parameter EMPTY_WIDTH = 3,
+    parameter READY_LATENCY = 1,
+    parameter RESET_CYCLES = 64
+  ) (
+    input clk,
+    input reset,
+    input [3:0] avalon_s_address,
+    input avalon_s_read,
+    output reg [31:0] avalon_s_readdata,
+    input avalon_s_write,
+    input [31:0] avalon_s_writedata,
+    input [DATA_WIDTH-1:0] din0_data,
+    input [EMPTY_WIDTH-1:0] din0_empty,
+    input din0_valid,
+    output din0_ready,
+    input din0_startofpacket,
+    input din0_endofpacket,
+    output [DATA_WIDTH-1:0] dout0_data,
+    output [EMPTY_WIDTH-1:0] dout0_empty,
+    output dout0_valid,
+    input dout0_ready,
+    output dout0_startofpacket,
+    output dout0_endofpacket,
+    input [DATA_WIDTH-1:0] din1_data,
+    input [EMPTY_WIDTH-1:0] din1_empty,
+    input din1_valid,
+    output din1_ready,
+    input din1_startofpacket,
+    input din1_endofpacket,
+    output [DATA_WIDTH-1:0] dout1_data,
+    output [EMPTY_WIDTH-1:0] dout1_empty,
+    output dout1_valid,
+    input dout1_ready,
+    output dout1_startofpacket,
+    output dout1_endofpacket,
+    input [DATA_WIDTH-1:0] din2_data,
+    input [EMPTY_WIDTH-1:0] din2_empty,
+    input din2_valid,
+    output din2_ready,
+    input din2_startofpacket,
+    input din2_endofpacket,
+    output [DATA_WIDTH-1:0] dout2_data,
+    output [EMPTY_WIDTH-1:0] dout2_empty,
+    output dout2_valid,
+    input dout2_ready,
+    output dout2_startofpacket,
+    output dout2_endofpacket,
+    input [DATA_WIDTH-1:0] din3_data,
+    input [EMPTY_WIDTH-1:0] din3_empty,
+    input din3_valid,
+    output din3_ready,
+    input din3_startofpacket,
+    input din3_endofpacket,
+    output [DATA_WIDTH-1:0] dout3_data,
+    output [EMPTY_WIDTH-1:0] dout3_empty,
+    output dout3_valid,
+    input dout3_ready,
+    output dout3_startofpacket,
+    output dout3_endofpacket,
+    output core_reset0,
+    output core_reset1,
+    output core_reset2,
+    output core_reset3
+);
+
+localparam NUM_LINKS = 4;
+localparam PKT_TYPE_CTRL = 4'hf;
+
+localparam REG_CTRL = 4'h0;
+localparam REG_STATUS = 4'h1;
+localparam REG_FORCE = 4'h2;
+
+wire [DATA_WIDTH-1:0] up_data [0:NUM_LINKS-1];
+wire [EMPTY_WIDTH-1:0] up_empty [0:NUM_LINKS-1];
+wire [NUM_LINKS-1:0] up_valid = {din3_valid, din2_valid, din1_valid, din0_valid};
+wire [NUM_LINKS-1:0] up_sop = {din3_startofpacket, din2_startofpacket, din1_startofpacket, din0_startofpacket};
+wire [NUM_LINKS-1:0] up_eop = {din3_endofpacket, din2_endofpacket, din1_endofpacket, din0_endofpacket};
+wire [NUM_LINKS-1:0] dn_ready = {dout3_ready, dout2_ready, dout1_ready, dout0_ready};
+wire [NUM_LINKS-1:0] up_ready, dn_valid, dn_sop, dn_eop;
+wire [DATA_WIDTH-1:0] dn_data [0:NUM_LINKS-1];
+wire [EMPTY_WIDTH-1:0] dn_empty [0:NUM_LINKS-1];
+
+assign up_data[0] = din0_data;
+assign up_data[1] = din1_data;
+assign up_data[2] = din2_data;
+assign up_data[3] = din3_data;
+assign up_empty[0] = din0_empty;
+assign up_empty[1] = din1_empty;
+assign up_empty[2] = din2_empty;
+assign up_empty[3] = din3_empty;
+
+assign {din3_ready, din2_ready, din1_ready, din0_ready} = up_ready;
+assign {dout3_valid, dout2_valid, dout1_valid, dout0_valid} = dn_valid;
+assign {dout3_startofpacket, dout2_startofpacket, dout1_startofpacket, dout0_startofpacket} = dn_sop;
+assign {dout3_endofpacket, dout2_endofpacket, dout1_endofpacket, dout0_endofpacket} = dn_eop;
+assign dout0_data = dn_data[0];
+assign dout1_data = dn_data[1];
+assign dout2_data = dn_data[2];
+assign dout3_data = dn_data[3];
+assign dout0_empty = dn_empty[0];
+assign dout1_empty = dn_empty[1];
+assign dout2_empty = dn_empty[2];
+assign dout3_empty = dn_empty[3];
+
+reg [NUM_LINKS-1:0] auto_en, recovered, in_pkt, drain, term, handled, dn_ready_prev;
+reg [15:0] timeout_us [0:NUM_LINKS-1];
+reg [15:0] stall_us [0:NUM_LINKS-1];
+reg [31:0] stall_cnt [0:NUM_LINKS-1];
+reg [7:0] rst_cnt [0:NUM_LINKS-1];
+reg [7:0] us_div;
+
+wire us_tick = (us_div == CLK_FREQ_MHZ-1);
+
+// With ready latency 1 a beat may only be presented when sink was ready on previous cycle
+wire [NUM_LINKS-1:0] dn_allowed = (READY_LATENCY != 0) ? dn_ready_prev : dn_ready;
+wire [NUM_LINKS-1:0] dn_xfer = dn_valid & ((READY_LATENCY != 0) ? {NUM_LINKS{1'b1}} : dn_ready);
+wire [NUM_LINKS-1:0] stall_raw = in_pkt & ~dn_ready;
+wire [NUM_LINKS-1:0] in_reset = {(rst_cnt[3] != 0), (rst_cnt[2] != 0), (rst_cnt[1] != 0), (rst_cnt[0] != 0)};
+wire [NUM_LINKS-1:0] force_rst = (avalon_s_write && (avalon_s_address == REG_FORCE)) ? avalon_s_writedata[NUM_LINKS-1:0] : {NUM_LINKS{1'b0}};
+wire [NUM_LINKS-1:0] stalled, stall_evt, rst_start;
+
+assign {core_reset3, core_reset2, core_reset1, core_reset0} = in_reset;
+
+genvar i;
+generate
+    for (i=0; i<NUM_LINKS; i=i+1) begin : gen_link
+        // drained beats are accepted and dropped, restart is only possible at a control packet
+        wire resume = ~in_reset[i] & up_valid[i] & up_sop[i] & (up_data[i][3:0] == PKT_TYPE_CTRL) & dn_allowed[i];
+
+        assign up_ready[i] = term[i] ? 1'b0 : (drain[i] ? 1'b1 : dn_ready[i]);
+        assign dn_valid[i] = term[i] ? dn_allowed[i] : (drain[i] ? resume : up_valid[i]);
+        assign dn_sop[i] = term[i] ? 1'b0 : up_sop[i];
+        assign dn_eop[i] = term[i] ? 1'b1 : up_eop[i];
+        assign dn_data[i] = term[i] ? {DATA_WIDTH{1'b0}} : up_data[i];
+        assign dn_empty[i] = term[i] ? {EMPTY_WIDTH{1'b0}} : up_empty[i];
+
+        assign stalled[i] = (timeout_us[i] != 0) & (stall_us[i] >= timeout_us[i]);
+        if (i < NUM_LINKS-1) begin : gen_dn
+            assign stall_evt[i] = stalled[i] & ~handled[i] & ~|stall_raw[NUM_LINKS-1:i+1];
+        end else begin : gen_last
+            assign stall_evt[i] = stalled[i] & ~handled[i];
+        end
+        assign rst_start[i] = ~in_reset[i] & (force_rst[i] | (stall_evt[i] & auto_en[i] & ~recovered[i]));
+    end
+endgenerate
+
+integer j;
+
+always @(posedge clk or posedge reset) begin
+    if (reset) begin
+        auto_en <= 0;
+        recovered <= 0;
+        in_pkt <= 0;
+        drain <= 0;
+        term <= 0;
+        handled <= 0;
+        dn_ready_prev <= 0;
+        us_div <= 0;
+        for (j=0; j<NUM_LINKS; j=j+1) begin
+            timeout_us[j] <= 0;
+            stall_us[j] <= 0;
+            stall_cnt[j] <= 0;
+            rst_cnt[j] <= 0;
+        end
+        avalon_s_readdata <= 0;
+    end else begin
+        if (us_tick)
+            us_div <= 0;
+        else
+            us_div <= us_div + 1'b1;
+
+        dn_ready_prev <= dn_ready;
+
+        for (j=0; j<NUM_LINKS; j=j+1) begin
+            if (dn_xfer[j])
+                in_pkt[j] <= dn_sop[j] ? ~dn_eop[j] : (in_pkt[j] & ~dn_eop[j]);
+
+            if (!stall_raw[j] || drain[j] || term[j]) begin
+                stall_us[j] <= 0;
+                handled[j] <= 1'b0;
+            end else if (us_tick && (stall_us[j] != 16'hffff)) begin
+                stall_us[j] <= stall_us[j] + 1'b1;
+            end
+
+            if (stall_evt[j]) begin
+                handled[j] <= 1'b1;
+                stall_cnt[j] <= stall_cnt[j] + 1'b1;
+            end
+
+            if (rst_start[j]) begin
+                rst_cnt[j] <= RESET_CYCLES;
+                recovered[j] <= 1'b1;
+                drain[j] <= 1'b1;
+                in_pkt[j] <= 1'b0;
+                // consumer of link j drives link j+1
+                if (j < NUM_LINKS-1)
+                    term[j+1] <= in_pkt[j+1];
+            end else if (rst_cnt[j] != 0) begin
+                rst_cnt[j] <= rst_cnt[j] - 1'b1;
+            end
+
+            if (drain[j] && !term[j] && dn_valid[j])
+                drain[j] <= 1'b0;
+            if (term[j] && dn_allowed[j])
+                term[j] <= 1'b0;
+        end
+
+        if (avalon_s_write) begin
+            case (avalon_s_address)
+                REG_CTRL:   auto_en <= avalon_s_writedata[NUM_LINKS-1:0];
+                REG_STATUS: recovered <= recovered & ~avalon_s_writedata[11:8];
+                4'h4, 4'h5, 4'h6, 4'h7: timeout_us[avalon_s_address[1:0]] <= avalon_s_writedata[15:0];
+                4'h8, 4'h9, 4'ha, 4'hb: stall_cnt[avalon_s_address[1:0]] <= 0;
+                default: ;
+            endcase
+        end
+
+        case (avalon_s_address)
+            REG_CTRL:   avalon_s_readdata <= {28'h0, auto_en};
+            REG_STATUS: avalon_s_readdata <= {16'h0, in_pkt, recovered, in_reset, stall_raw};
+            4'h4, 4'h5, 4'h6, 4'h7: avalon_s_readdata <= {16'h0, timeout_us[avalon_s_address[1:0]]};
+            4'h8, 4'h9, 4'ha, 4'hb: avalon_s_readdata <= stall_cnt[avalon_s_address[1:0]];
+            default:    avalon_s_readdata <= 32'h0;
+        endcase
+    end
+end
+
+endmodule
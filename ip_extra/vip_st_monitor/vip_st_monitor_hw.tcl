@@ -0,0 +1,140 @@
+#
+# Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+#
+# This file is part of Open Source Scan Converter project.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+
+package require -exact qsys 16.1
+
+set_module_property DESCRIPTION "VIP Avalon-ST link stall monitor"
+set_module_property NAME vip_st_monitor
+set_module_property VERSION 1.0
+set_module_property INTERNAL false
+set_module_property OPAQUE_ADDRESS_MAP true
+set_module_property GROUP "Other"
+set_module_property AUTHOR "Markus Hiienkari"
+set_module_property DISPLAY_NAME vip_st_monitor
+set_module_property INSTANTIATE_IN_SYSTEM_MODULE true
+set_module_property EDITABLE true
+set_module_property REPORT_TO_TALKBACK false
+set_module_property ALLOW_GREYBOX_GENERATION false
+set_module_property REPORT_HIERARCHY false
+set_module_property ELABORATION_CALLBACK elaborate
+
+add_fileset QUARTUS_SYNTH QUARTUS_SYNTH "" ""
+set_fileset_property QUARTUS_SYNTH TOP_LEVEL vip_st_monitor
+set_fileset_property QUARTUS_SYNTH ENABLE_RELATIVE_INCLUDE_PATHS false
+set_fileset_property QUARTUS_SYNTH ENABLE_FILE_OVERWRITE_MODE false
+add_fileset_file vip_st_monitor.v VERILOG PATH vip_st_monitor.v TOP_LEVEL_FILE
+
+add_parameter CLK_FREQ_MHZ INTEGER 148
+set_parameter_property CLK_FREQ_MHZ DISPLAY_NAME "Clock frequency (MHz)"
+set_parameter_property CLK_FREQ_MHZ HDL_PARAMETER true
+add_parameter BITS_PER_SYMBOL INTEGER 8
+set_parameter_property BITS_PER_SYMBOL DISPLAY_NAME "Bits per color sample"
+set_parameter_property BITS_PER_SYMBOL HDL_PARAMETER false
+add_parameter SYMBOLS_PER_BEAT INTEGER 6
+set_parameter_property SYMBOLS_PER_BEAT DISPLAY_NAME "Color planes x pixels in parallel"
+set_parameter_property SYMBOLS_PER_BEAT HDL_PARAMETER false
+add_parameter DATA_WIDTH INTEGER 48
+set_parameter_property DATA_WIDTH DERIVED true
+set_parameter_property DATA_WIDTH HDL_PARAMETER true
+set_parameter_property DATA_WIDTH VISIBLE false
+add_parameter EMPTY_WIDTH INTEGER 3
+set_parameter_property EMPTY_WIDTH DERIVED true
+set_parameter_property EMPTY_WIDTH HDL_PARAMETER true
+set_parameter_property EMPTY_WIDTH VISIBLE false
+add_parameter PIXELS_IN_PARALLEL INTEGER 2
+set_parameter_property PIXELS_IN_PARALLEL DISPLAY_NAME "Pixels in parallel"
+set_parameter_property PIXELS_IN_PARALLEL ALLOWED_RANGES {1 2}
+set_parameter_property PIXELS_IN_PARALLEL HDL_PARAMETER false
+add_parameter READY_LATENCY INTEGER 1
+set_parameter_property READY_LATENCY DISPLAY_NAME "Ready latency"
+set_parameter_property READY_LATENCY ALLOWED_RANGES 0:1
+set_parameter_property READY_LATENCY HDL_PARAMETER true
+add_parameter RESET_CYCLES INTEGER 64
+set_parameter_property RESET_CYCLES DISPLAY_NAME "Core reset length (cycles)"
+set_parameter_property RESET_CYCLES ALLOWED_RANGES 16:255
+set_parameter_property RESET_CYCLES HDL_PARAMETER true
+
+add_interface clock clock end
+set_interface_property clock clockRate 0
+add_interface_port clock clk clk Input 1
+
+add_interface reset reset end
+set_interface_property reset associatedClock clock
+set_interface_property reset synchronousEdges DEASSERT
+add_interface_port reset reset reset Input 1
+
+add_interface avalon_s avalon end
+set_interface_property avalon_s addressUnits WORDS
+set_interface_property avalon_s associatedClock clock
+set_interface_property avalon_s associatedReset reset
+set_interface_property avalon_s readLatency 1
+set_interface_property avalon_s readWaitTime 0
+set_interface_property avalon_s writeWaitTime 0
+set_interface_property avalon_s maximumPendingReadTransactions 0
+add_interface_port avalon_s avalon_s_address address Input 4
+add_interface_port avalon_s avalon_s_read read Input 1
+add_interface_port avalon_s avalon_s_readdata readdata Output 32
+add_interface_port avalon_s avalon_s_write write Input 1
+add_interface_port avalon_s avalon_s_writedata writedata Input 32
+
+# din<i>/dout<i> pass through link i, core_reset<i> goes to the consumer core of link i
+for {set i 0} {$i < 4} {incr i} {
+    foreach {dir role} {din end dout start} {
+        add_interface ${dir}${i} avalon_streaming $role
+        set_interface_property ${dir}${i} associatedClock clock
+        set_interface_property ${dir}${i} associatedReset reset
+        set_interface_property ${dir}${i} maxChannel 0
+        set_interface_property ${dir}${i} errorDescriptor ""
+    }
+    add_interface_port din${i} din${i}_data data Input DATA_WIDTH
+    add_interface_port din${i} din${i}_empty empty Input EMPTY_WIDTH
+    add_interface_port din${i} din${i}_valid valid Input 1
+    add_interface_port din${i} din${i}_ready ready Output 1
+    add_interface_port din${i} din${i}_startofpacket startofpacket Input 1
+    add_interface_port din${i} din${i}_endofpacket endofpacket Input 1
+    add_interface_port dout${i} dout${i}_data data Output DATA_WIDTH
+    add_interface_port dout${i} dout${i}_empty empty Output EMPTY_WIDTH
+    add_interface_port dout${i} dout${i}_valid valid Output 1
+    add_interface_port dout${i} dout${i}_ready ready Input 1
+    add_interface_port dout${i} dout${i}_startofpacket startofpacket Output 1
+    add_interface_port dout${i} dout${i}_endofpacket endofpacket Output 1
+
+    add_interface core_reset${i} reset start
+    set_interface_property core_reset${i} associatedClock clock
+    set_interface_property core_reset${i} associatedDirectReset ""
+    set_interface_property core_reset${i} associatedResetSinks reset
+    set_interface_property core_reset${i} synchronousEdges DEASSERT
+    add_interface_port core_reset${i} core_reset${i} reset Output 1
+}
+
+proc elaborate {} {
+    set symbols [get_parameter_value SYMBOLS_PER_BEAT]
+    set_parameter_value DATA_WIDTH [expr {[get_parameter_value BITS_PER_SYMBOL] * $symbols}]
+    set_parameter_value EMPTY_WIDTH [expr {($symbols > 2) ? int(ceil(log($symbols)/log(2))) : 1}]
+
+    for {set i 0} {$i < 4} {incr i} {
+        foreach dir {din dout} {
+            set_interface_property ${dir}${i} dataBitsPerSymbol [get_parameter_value BITS_PER_SYMBOL]
+            set_interface_property ${dir}${i} symbolsPerBeat [get_parameter_value SYMBOLS_PER_BEAT]
+            set_interface_property ${dir}${i} readyLatency [get_parameter_value READY_LATENCY]
+            # empty is only used by VIP cores when several pixels are transferred per beat
+            set_port_property ${dir}${i}_empty TERMINATION [expr {[get_parameter_value PIXELS_IN_PARALLEL] == 1}]
+        }
+    }
+}
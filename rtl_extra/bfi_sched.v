@@ -0,0 +1,101 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+// Black frame insertion for frame multiplication modes. Output frames are counted from the
+// latest input frame start so that the first output frame(s) of each input frame are shown
+// and the rest blanked, independent of output/input phase. Data path is combinational so
+// that sync/DE alignment of the following output stage is unchanged.
+
+module bfi_sched #(
+    parameter YPOS_WIDTH = 11
+  ) (
+    input PCLK_CAP_i,
+    input PCLK_OUT_i,
+    input reset_n,
+    input [1:0] lit_frames_i,       // shown frames per input frame, 0 = BFI disabled
+    input frame_change_i,           // input frame start, PCLK_CAP_i domain
+    input [YPOS_WIDTH-1:0] ypos_i,  // output line position, PCLK_OUT_i domain
+    input [7:0] R_i,
+    input [7:0] G_i,
+    input [7:0] B_i,
+    output [7:0] R_o,
+    output [7:0] G_o,
+    output [7:0] B_o,
+    output reg [1:0] frame_idx_o
+);
+
+reg frame_change_prev, in_sof_toggle;
+reg in_sof_sync1_reg, in_sof_sync2_reg, in_sof_prev, in_sof_pending;
+reg [YPOS_WIDTH-1:0] ypos_prev;
+reg blank;
+
+wire out_sof = (ypos_i < ypos_prev);
+
+always @(posedge PCLK_CAP_i or negedge reset_n) begin
+    if (!reset_n) begin
+        frame_change_prev <= 1'b0;
+        in_sof_toggle <= 1'b0;
+    end else begin
+        frame_change_prev <= frame_change_i;
+        if (frame_change_i & ~frame_change_prev)
+            in_sof_toggle <= ~in_sof_toggle;
+    end
+end
+
+always @(posedge PCLK_OUT_i or negedge reset_n) begin
+    if (!reset_n) begin
+        in_sof_sync1_reg <= 1'b0;
+        in_sof_sync2_reg <= 1'b0;
+        in_sof_prev <= 1'b0;
+        in_sof_pending <= 1'b0;
+        ypos_prev <= 0;
+        frame_idx_o <= 2'h0;
+        blank <= 1'b0;
+    end else begin
+        in_sof_sync1_reg <= in_sof_toggle;
+        in_sof_sync2_reg <= in_sof_sync1_reg;
+        in_sof_prev <= in_sof_sync2_reg;
+        ypos_prev <= ypos_i;
+
+        if (out_sof) begin
+            // output frame restarted by framelock after input SOF is the first one of new input frame
+            if (in_sof_pending | (in_sof_sync2_reg ^ in_sof_prev)) begin
+                frame_idx_o <= 2'h0;
+                blank <= 1'b0;
+            end else begin
+                if (frame_idx_o != 2'h3)
+                    frame_idx_o <= frame_idx_o + 1'b1;
+                blank <= (lit_frames_i != 2'h0) & ({1'b0, frame_idx_o} + 1'b1 >= lit_frames_i);
+            end
+            in_sof_pending <= 1'b0;
+        end else if (in_sof_sync2_reg ^ in_sof_prev) begin
+            in_sof_pending <= 1'b1;
+        end
+
+        if (lit_frames_i == 2'h0)
+            blank <= 1'b0;
+    end
+end
+
+assign R_o = blank ? 8'h00 : R_i;
+assign G_o = blank ? 8'h00 : G_i;
+assign B_o = blank ? 8'h00 : B_i;
+
+endmodule
@@ -0,0 +1,151 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+// Bandwidth and latency counters for the line multiplier EMIF ports. Events are counted over windows
+// of 2^WINDOW_LOG2 cycles and latched at window end. Read latency is sampled from one command at a
+// time, from command accept to its first readdatavalid, skipping beats still outstanding from earlier
+// commands. Latched fields are read 13 bits at a time via sel_i; window sequence number lets reader
+// detect a snapshot update between accesses.
+
+module emif_perf_mon #(
+    parameter WINDOW_LOG2 = 24
+  ) (
+    input clk,
+    input reset_n,
+    input rd_read,
+    input rd_waitrequest,
+    input [5:0] rd_burstcount,
+    input rd_readdatavalid,
+    input wr_write,
+    input wr_waitrequest,
+    input [3:0] sel_i,              // asynchronous, quasi-static
+    output reg [12:0] data_o
+);
+
+reg [WINDOW_LOG2-1:0] window_ctr;
+reg [25:0] rd_beats, wr_beats, lat_sum, lat_cnt, rd_stall;
+reg [25:0] rd_beats_l, wr_beats_l, lat_sum_l, lat_cnt_l, rd_stall_l;
+reg [12:0] lat_max, lat_max_l, seq;
+reg [15:0] outstanding, lat_skip, lat_timer;
+reg lat_active;
+reg [3:0] sel_sync1_reg, sel_sync2_reg;
+
+wire rd_acc = rd_read & ~rd_waitrequest;
+wire [15:0] lat_cycles = lat_timer + 1'b1;
+
+always @(posedge clk or negedge reset_n) begin
+    if (!reset_n) begin
+        window_ctr <= 0;
+        rd_beats <= 0;
+        wr_beats <= 0;
+        lat_sum <= 0;
+        lat_cnt <= 0;
+        rd_stall <= 0;
+        lat_max <= 0;
+        rd_beats_l <= 0;
+        wr_beats_l <= 0;
+        lat_sum_l <= 0;
+        lat_cnt_l <= 0;
+        rd_stall_l <= 0;
+        lat_max_l <= 0;
+        seq <= 0;
+        outstanding <= 0;
+        lat_skip <= 0;
+        lat_timer <= 0;
+        lat_active <= 1'b0;
+    end else begin
+        outstanding <= outstanding + (rd_acc ? rd_burstcount : 6'h0) - rd_readdatavalid;
+
+        if (lat_active) begin
+            if (lat_timer != 16'hffff)
+                lat_timer <= lat_timer + 1'b1;
+            if (rd_readdatavalid) begin
+                if (lat_skip == 0)
+                    lat_active <= 1'b0;
+                else
+                    lat_skip <= lat_skip - 1'b1;
+            end
+        end else if (rd_acc) begin
+            // beats of earlier commands arrive first; the one returned this cycle is already one of them
+            lat_active <= 1'b1;
+            lat_timer <= 0;
+            lat_skip <= outstanding - rd_readdatavalid;
+        end
+
+        if (window_ctr == {WINDOW_LOG2{1'b1}}) begin
+            rd_beats_l <= rd_beats;
+            wr_beats_l <= wr_beats;
+            lat_sum_l <= lat_sum;
+            lat_cnt_l <= lat_cnt;
+            rd_stall_l <= rd_stall;
+            lat_max_l <= lat_max;
+            seq <= seq + 1'b1;
+            rd_beats <= 0;
+            wr_beats <= 0;
+            lat_sum <= 0;
+            lat_cnt <= 0;
+            rd_stall <= 0;
+            lat_max <= 0;
+        end else begin
+            rd_beats <= rd_beats + rd_readdatavalid;
+            wr_beats <= wr_beats + (wr_write & ~wr_waitrequest);
+            rd_stall <= rd_stall + (rd_read & rd_waitrequest);
+            if (lat_active & rd_readdatavalid & (lat_skip == 0)) begin
+                lat_sum <= lat_sum + lat_cycles;
+                lat_cnt <= lat_cnt + 1'b1;
+                if ((lat_cycles > {3'h0, lat_max}) && (lat_max != 13'h1fff))
+                    lat_max <= (lat_cycles[15:13] != 3'h0) ? 13'h1fff : lat_cycles[12:0];
+            end
+        end
+        window_ctr <= window_ctr + 1'b1;
+    end
+end
+
+always @(posedge clk or negedge reset_n) begin
+    if (!reset_n) begin
+        sel_sync1_reg <= 4'h0;
+        sel_sync2_reg <= 4'h0;
+        data_o <= 13'h0;
+    end else begin
+        sel_sync1_reg <= sel_i;
+        sel_sync2_reg <= sel_sync1_reg;
+
+        // 0-1: read beats, 2-3: write beats, 4-5: sum of sampled read latencies in cycles,
+        // 6-7: latency samples, 8-9: cycles with read command waiting (lo/hi each),
+        // a: max sampled read latency in cycles, b: window sequence number
+        case (sel_sync2_reg)
+            4'h0:    data_o <= rd_beats_l[12:0];
+            4'h1:    data_o <= rd_beats_l[25:13];
+            4'h2:    data_o <= wr_beats_l[12:0];
+            4'h3:    data_o <= wr_beats_l[25:13];
+            4'h4:    data_o <= lat_sum_l[12:0];
+            4'h5:    data_o <= lat_sum_l[25:13];
+            4'h6:    data_o <= lat_cnt_l[12:0];
+            4'h7:    data_o <= lat_cnt_l[25:13];
+            4'h8:    data_o <= rd_stall_l[12:0];
+            4'h9:    data_o <= rd_stall_l[25:13];
+            4'ha:    data_o <= lat_max_l;
+            4'hb:    data_o <= seq;
+            default: data_o <= 13'h0;
+        endcase
+    end
+end
+
+endmodule
@@ -0,0 +1,323 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+// Scheduler between scanconverter line buffer ports and emif_bridge_0. Write beats are collected
+// into a local buffer and issued as a single burst of up to MAX_BURST beats once the address stream
+// becomes discontinuous, buffer fills up, writes stall for WR_FLUSH_TIMEOUT cycles or a read needs
+// the pending data. Reads are served from a sequential prefetch stream that is kept pf_dist_i bursts
+// ahead of the last request; a request that does not continue the stream restarts it. Line stride is
+// not visible here, so prefetch only runs ahead within a line and restarts on every line jump.
+// Prefetched data overlapping a newer write is discarded. Optional bank swizzle XORs row LSBs into
+// bank address bits so that consecutive line buffers map to different banks. Swizzle requires that
+// line buffer region is aligned to 2^(ROW_LSB+BANK_BITS) bytes and that upstream bursts do not cross
+// 2^BANK_LSB boundary. No board enables it since neither requirement is guaranteed in this tree.
+// Prefetch buffer must hold at least two maximum length upstream bursts (PF_DEPTH_LOG2 >= 7).
+
+module emif_sched #(
+    parameter AW = 28,
+    parameter BEAT_LOG2 = 5,
+    parameter MAX_BURST = 32,
+    parameter WR_FLUSH_TIMEOUT = 15,
+    parameter PF_DEPTH_LOG2 = 7,
+    parameter TAG_DEPTH_LOG2 = 3,
+    parameter BANK_SWIZZLE = 0,
+    parameter BANK_LSB = 13,
+    parameter BANK_BITS = 3,
+    parameter ROW_LSB = 16
+  ) (
+    input clk,
+    input reset_n,
+    input [2:0] pf_dist_i,
+    // upstream (scanconverter)
+    input [AW-1:0] us_rd_addr,
+    input us_rd_read,
+    output [255:0] us_rd_rdata,
+    output us_rd_waitrequest,
+    output us_rd_readdatavalid,
+    input [5:0] us_rd_burstcount,
+    input [AW-1:0] us_wr_addr,
+    input us_wr_write,
+    input [255:0] us_wr_wdata,
+    output us_wr_waitrequest,
+    input [5:0] us_wr_burstcount,
+    // downstream (emif_bridge_0)
+    output [AW-1:0] dn_rd_addr,
+    output dn_rd_read,
+    input [255:0] dn_rd_rdata,
+    input dn_rd_waitrequest,
+    input dn_rd_readdatavalid,
+    output [5:0] dn_rd_burstcount,
+    output [AW-1:0] dn_wr_addr,
+    output dn_wr_write,
+    output [255:0] dn_wr_wdata,
+    input dn_wr_waitrequest,
+    output [5:0] dn_wr_burstcount
+);
+
+localparam PF_DEPTH = (1<<PF_DEPTH_LOG2);
+localparam TAG_DEPTH = (1<<TAG_DEPTH_LOG2);
+
+function [AW-1:0] swz;
+    input [AW-1:0] a;
+    begin
+        swz = a;
+        if (BANK_SWIZZLE)
+            swz[BANK_LSB +: BANK_BITS] = a[BANK_LSB +: BANK_BITS] ^ a[ROW_LSB +: BANK_BITS];
+    end
+endfunction
+
+// number of beats until next 2^BANK_LSB boundary, limited to MAX_BURST
+function [6:0] seg_beats;
+    input [AW-1:0] a;
+    reg [BANK_LSB:0] rem;
+    begin
+        rem = (1<<BANK_LSB) - a[BANK_LSB-1:0];
+        if (!BANK_SWIZZLE || ((rem >> BEAT_LOG2) >= MAX_BURST))
+            seg_beats = MAX_BURST;
+        else
+            seg_beats = rem >> BEAT_LOG2;
+    end
+endfunction
+
+reg [2:0] pf_dist_sync1_reg, pf_dist_sync2_reg;
+
+
+// ---- write combining ----
+
+reg [255:0] wc_mem [0:MAX_BURST-1];
+reg [255:0] wc_q;
+reg [AW-1:0] wc_addr;
+reg [6:0] wc_cnt, wc_fl_idx;
+reg [5:0] wc_timer;
+reg wc_flush;
+
+reg [5:0] us_wr_beats_left;
+reg [AW-1:0] us_wr_next_addr;
+
+wire [AW-1:0] wc_end = wc_addr + (wc_cnt << BEAT_LOG2);
+wire [AW-1:0] wr_beat_addr = (us_wr_beats_left != 0) ? us_wr_next_addr : us_wr_addr;
+wire wc_can_append = (wc_cnt == 0) | ((wr_beat_addr == wc_end) & (wc_cnt < seg_beats(wc_addr)));
+wire us_wr_acc = us_wr_write & ~us_wr_waitrequest;
+wire dn_wr_acc = dn_wr_write & ~dn_wr_waitrequest;
+wire [6:0] wc_fl_idx_next = dn_wr_acc ? wc_fl_idx + 1'b1 : wc_fl_idx;
+wire wc_rd_hazard;
+
+assign us_wr_waitrequest = wc_flush | ~wc_can_append;
+assign dn_wr_addr = swz(wc_addr);
+assign dn_wr_write = wc_flush;
+assign dn_wr_wdata = wc_q;
+assign dn_wr_burstcount = wc_cnt[5:0];
+
+always @(posedge clk) begin
+    if (us_wr_acc)
+        wc_mem[wc_cnt] <= us_wr_wdata;
+    wc_q <= wc_mem[wc_fl_idx_next];
+end
+
+always @(posedge clk or negedge reset_n) begin
+    if (!reset_n) begin
+        wc_addr <= 0;
+        wc_cnt <= 0;
+        wc_fl_idx <= 0;
+        wc_timer <= 0;
+        wc_flush <= 1'b0;
+        us_wr_beats_left <= 0;
+        us_wr_next_addr <= 0;
+    end else begin
+        if (us_wr_acc) begin
+            if (wc_cnt == 0)
+                wc_addr <= wr_beat_addr;
+            wc_cnt <= wc_cnt + 1'b1;
+            wc_timer <= 0;
+            us_wr_beats_left <= (us_wr_beats_left != 0) ? us_wr_beats_left - 1'b1 : us_wr_burstcount - 1'b1;
+            us_wr_next_addr <= wr_beat_addr + (1<<BEAT_LOG2);
+        end else if (wc_flush) begin
+            wc_fl_idx <= wc_fl_idx_next;
+            if (dn_wr_acc && (wc_fl_idx == wc_cnt-1'b1)) begin
+                wc_flush <= 1'b0;
+                wc_cnt <= 0;
+                wc_fl_idx <= 0;
+                wc_timer <= 0;
+            end
+        end else if (wc_cnt != 0) begin
+            if ((us_wr_write & ~wc_can_append) | (wc_cnt == seg_beats(wc_addr)) | (wc_timer == WR_FLUSH_TIMEOUT) | wc_rd_hazard)
+                wc_flush <= 1'b1;
+            else
+                wc_timer <= wc_timer + 1'b1;
+        end
+    end
+end
+
+
+// ---- read prefetch ----
+
+reg [255:0] pf_mem [0:PF_DEPTH-1];
+reg [255:0] serve_q;
+reg serve_valid;
+reg [PF_DEPTH_LOG2-1:0] pf_wr_ptr, pf_rd_ptr;
+reg [PF_DEPTH_LOG2:0] pf_landed, pf_inflight, serve_cnt;
+reg [AW-1:0] pf_head, pf_tail;
+reg pf_valid;
+reg [15:0] discard_cnt;
+reg [15:0] direct_pending;
+
+// outstanding downstream commands in issue order
+reg tag_is_pf [0:TAG_DEPTH-1];
+reg [5:0] tag_beats [0:TAG_DEPTH-1];
+reg [TAG_DEPTH_LOG2-1:0] tag_wr_ptr, tag_rd_ptr;
+reg [TAG_DEPTH_LOG2:0] tag_cnt;
+reg [5:0] tag_ret_cnt;
+
+// downstream command register
+reg cmd_valid, cmd_is_pf;
+reg [AW-1:0] cmd_addr;
+reg [5:0] cmd_beats;
+
+wire [PF_DEPTH_LOG2:0] pf_ahead = pf_landed + pf_inflight - serve_cnt;
+wire [6:0] pf_len = seg_beats(pf_tail);
+wire [AW-1:0] us_rd_end = us_rd_addr + (us_rd_burstcount << BEAT_LOG2);
+wire [AW-1:0] pf_next_end = pf_tail + (pf_len << BEAT_LOG2);
+
+wire cmd_free = ~cmd_valid | ~dn_rd_waitrequest;
+wire tag_space = (tag_cnt < TAG_DEPTH-1);
+
+// request continuing the stream waits for prefetch to catch up instead of restarting it
+wire rd_stream = us_rd_read & pf_valid & (us_rd_addr == pf_head);
+wire rd_hit = rd_stream & ({1'b0, us_rd_burstcount} <= pf_ahead);
+wire rd_follow = rd_stream & ~rd_hit;
+assign wc_rd_hazard = us_rd_read & ~rd_hit & (wc_cnt != 0) & (us_rd_addr < wc_end) & (us_rd_end > wc_addr);
+wire rd_miss_go = us_rd_read & ~rd_stream & ~wc_rd_hazard & ~wc_flush & (serve_cnt == 0) & ~serve_valid & cmd_free & tag_space;
+wire pf_go = ~rd_miss_go & pf_valid & (pf_dist_sync2_reg != 0) & cmd_free & tag_space & ~us_wr_acc &
+             ((pf_landed + pf_inflight + pf_len) <= PF_DEPTH) &
+             ((pf_ahead < pf_dist_sync2_reg*MAX_BURST) | rd_follow) &
+             ((wc_cnt == 0) | (pf_next_end <= wc_addr) | (pf_tail >= wc_end));
+wire pf_inval = us_wr_acc & (wr_beat_addr >= pf_head) & (wr_beat_addr < pf_tail);
+
+wire ret_is_pf = tag_is_pf[tag_rd_ptr];
+wire ret_drop = dn_rd_readdatavalid & ret_is_pf & (discard_cnt != 0);
+wire ret_land = dn_rd_readdatavalid & ret_is_pf & (discard_cnt == 0);
+wire ret_direct = dn_rd_readdatavalid & ~ret_is_pf;
+wire ret_last = dn_rd_readdatavalid & (tag_ret_cnt == tag_beats[tag_rd_ptr]-1'b1);
+wire serve_go = (serve_cnt != 0) & (direct_pending == 0) & (pf_landed != 0);
+
+assign us_rd_waitrequest = ~(rd_hit | rd_miss_go);
+assign us_rd_readdatavalid = ret_direct | serve_valid;
+assign us_rd_rdata = serve_valid ? serve_q : dn_rd_rdata;
+assign dn_rd_addr = swz(cmd_addr);
+assign dn_rd_read = cmd_valid;
+assign dn_rd_burstcount = cmd_beats;
+
+always @(posedge clk) begin
+    if (ret_land)
+        pf_mem[pf_wr_ptr] <= dn_rd_rdata;
+    serve_q <= pf_mem[pf_rd_ptr];
+    if (rd_miss_go | pf_go) begin
+        tag_is_pf[tag_wr_ptr] <= pf_go;
+        tag_beats[tag_wr_ptr] <= rd_miss_go ? us_rd_burstcount : pf_len[5:0];
+    end
+end
+
+always @(posedge clk or negedge reset_n) begin
+    if (!reset_n) begin
+        pf_dist_sync1_reg <= 0;
+        pf_dist_sync2_reg <= 0;
+        serve_valid <= 1'b0;
+        pf_wr_ptr <= 0;
+        pf_rd_ptr <= 0;
+        pf_landed <= 0;
+        pf_inflight <= 0;
+        serve_cnt <= 0;
+        pf_head <= 0;
+        pf_tail <= 0;
+        pf_valid <= 1'b0;
+        discard_cnt <= 0;
+        direct_pending <= 0;
+        tag_wr_ptr <= 0;
+        tag_rd_ptr <= 0;
+        tag_cnt <= 0;
+        tag_ret_cnt <= 0;
+        cmd_valid <= 1'b0;
+        cmd_is_pf <= 1'b0;
+        cmd_addr <= 0;
+        cmd_beats <= 0;
+    end else begin
+        pf_dist_sync1_reg <= pf_dist_i;
+        pf_dist_sync2_reg <= pf_dist_sync1_reg;
+
+        // downstream command slot
+        if (rd_miss_go) begin
+            cmd_valid <= 1'b1;
+            cmd_is_pf <= 1'b0;
+            cmd_addr <= us_rd_addr;
+            cmd_beats <= us_rd_burstcount;
+        end else if (pf_go) begin
+            cmd_valid <= 1'b1;
+            cmd_is_pf <= 1'b1;
+            cmd_addr <= pf_tail;
+            cmd_beats <= pf_len[5:0];
+        end else if (cmd_free) begin
+            cmd_valid <= 1'b0;
+        end
+
+        // tag queue
+        if (rd_miss_go | pf_go)
+            tag_wr_ptr <= tag_wr_ptr + 1'b1;
+        if (ret_last) begin
+            tag_rd_ptr <= tag_rd_ptr + 1'b1;
+            tag_ret_cnt <= 0;
+        end else if (dn_rd_readdatavalid) begin
+            tag_ret_cnt <= tag_ret_cnt + 1'b1;
+        end
+        tag_cnt <= tag_cnt + (rd_miss_go | pf_go) - ret_last;
+
+        direct_pending <= direct_pending + (rd_miss_go ? us_rd_burstcount : 0) - ret_direct;
+
+        // serve prefetched beats to upstream in order
+        serve_valid <= serve_go;
+        if (serve_go)
+            pf_rd_ptr <= pf_rd_ptr + 1'b1;
+        serve_cnt <= serve_cnt + (rd_hit ? us_rd_burstcount : 0) - serve_go;
+
+        if (rd_miss_go) begin
+            // restart stream after requested burst, dropping everything still in flight
+            pf_wr_ptr <= pf_rd_ptr;
+            pf_landed <= 0;
+            pf_inflight <= 0;
+            discard_cnt <= discard_cnt - ret_drop + pf_inflight - ret_land;
+            pf_head <= us_rd_end;
+            pf_tail <= us_rd_end;
+            pf_valid <= (pf_dist_sync2_reg != 0);
+        end else begin
+            if (ret_land)
+                pf_wr_ptr <= pf_wr_ptr + 1'b1;
+            pf_landed <= pf_landed + ret_land - serve_go;
+            pf_inflight <= pf_inflight + (pf_go ? pf_len : 0) - ret_land;
+            discard_cnt <= discard_cnt - ret_drop;
+            if (rd_hit)
+                pf_head <= us_rd_end;
+            if (pf_go)
+                pf_tail <= pf_next_end;
+            if (pf_inval | (pf_dist_sync2_reg == 0))
+                pf_valid <= 1'b0;
+        end
+    end
+end
+
+endmodule
@@ -0,0 +1,165 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+
+// Adapter from 256-bit line buffer EMIF interface (emif_sched downstream side) to a narrow SDR SDRAM
+// port of emif_bridge_0. Each upstream beat becomes one downstream burst of 256/DN_DW words, lowest
+// word first, so that a beat never crosses an SDRAM row and is transferred as one uninterrupted burst.
+// Read commands are split per beat and issued back-to-back; returned words are assembled in order.
+// A read overlapping the beat still being written out is held until the write has been issued.
+// Line buffer addresses are offset by LM_BASE and limited to a 2^WIN_AW byte window so that LM traffic
+// stays in a separate bank pair from VIP buffers. altera_avalon_new_sdram_controller with 4 banks maps
+// byte address of a 32-bit SDRAM (10 column, 13 row bits) as {bank[1], row, bank[0], column}, i.e.
+// bank[1] at [26], row [25:13], bank[0] at [12] and column [11:2]. Window base 0x04000000 thus
+// selects banks 2/3, and bank[0] alternates every 4KB row so that a sequential line buffer stream
+// is already interleaved between the two banks without address remapping. As commands are issued
+// per beat, no alignment is required from upstream bursts. Upstream write address is only valid on
+// first beat of a burst (Avalon burst semantics), later beat addresses are derived locally.
+
+module emif_sdr_adapter #(
+    parameter AW = 28,
+    parameter DN_AW = 32,
+    parameter DN_DW = 32,
+    parameter LM_BASE = 32'h04000000,
+    parameter WIN_AW = 26
+  ) (
+    input clk,
+    input reset_n,
+    // upstream (emif_sched)
+    input [AW-1:0] us_rd_addr,
+    input us_rd_read,
+    output [255:0] us_rd_rdata,
+    output us_rd_waitrequest,
+    output reg us_rd_readdatavalid,
+    input [5:0] us_rd_burstcount,
+    input [AW-1:0] us_wr_addr,
+    input us_wr_write,
+    input [255:0] us_wr_wdata,
+    output us_wr_waitrequest,
+    input [5:0] us_wr_burstcount,
+    // downstream (emif_bridge_0)
+    output [DN_AW-1:0] dn_rd_addr,
+    output dn_rd_read,
+    input [DN_DW-1:0] dn_rd_rdata,
+    input dn_rd_waitrequest,
+    input dn_rd_readdatavalid,
+    output [5:0] dn_rd_burstcount,
+    output [DN_AW-1:0] dn_wr_addr,
+    output dn_wr_write,
+    output [DN_DW-1:0] dn_wr_wdata,
+    input dn_wr_waitrequest,
+    output [5:0] dn_wr_burstcount
+);
+
+localparam RATIO = 256/DN_DW;
+localparam BEAT_BYTES = 32;
+
+function [DN_AW-1:0] dn_map;
+    input [AW-1:0] a;
+    begin
+        dn_map = LM_BASE + a[WIN_AW-1:0];
+    end
+endfunction
+
+
+// ---- write path ----
+
+reg [255:0] wr_sr;
+reg [AW-1:0] wr_addr;
+reg [5:0] wr_words;
+reg [5:0] us_wr_beats_left;
+reg [AW-1:0] us_wr_next_addr;
+
+wire [AW-1:0] wr_beat_addr = (us_wr_beats_left != 0) ? us_wr_next_addr : us_wr_addr;
+wire us_wr_acc = us_wr_write & ~us_wr_waitrequest;
+wire dn_wr_acc = dn_wr_write & ~dn_wr_waitrequest;
+
+assign us_wr_waitrequest = (wr_words != 0);
+assign dn_wr_addr = dn_map(wr_addr);
+assign dn_wr_write = (wr_words != 0);
+assign dn_wr_wdata = wr_sr[DN_DW-1:0];
+assign dn_wr_burstcount = RATIO;
+
+always @(posedge clk or negedge reset_n) begin
+    if (!reset_n) begin
+        wr_sr <= 0;
+        wr_addr <= 0;
+        wr_words <= 0;
+        us_wr_beats_left <= 0;
+        us_wr_next_addr <= 0;
+    end else begin
+        if (us_wr_acc) begin
+            wr_sr <= us_wr_wdata;
+            wr_addr <= wr_beat_addr;
+            wr_words <= RATIO;
+            us_wr_beats_left <= (us_wr_beats_left != 0) ? us_wr_beats_left - 1'b1 : us_wr_burstcount - 1'b1;
+            us_wr_next_addr <= wr_beat_addr + BEAT_BYTES;
+        end else if (dn_wr_acc) begin
+            wr_sr <= wr_sr >> DN_DW;
+            wr_words <= wr_words - 1'b1;
+        end
+    end
+end
+
+
+// ---- read path ----
+
+reg [255:0] rd_sr;
+reg [AW-1:0] rd_cmd_addr;
+reg [5:0] rd_cmd_left;
+reg [5:0] rd_word_cnt;
+
+wire [AW-1:0] us_rd_end = us_rd_addr + (us_rd_burstcount * BEAT_BYTES);
+wire rd_wr_hazard = (wr_words != 0) & (wr_addr >= us_rd_addr) & (wr_addr < us_rd_end);
+wire us_rd_acc = us_rd_read & ~us_rd_waitrequest;
+wire dn_rd_acc = dn_rd_read & ~dn_rd_waitrequest;
+
+assign us_rd_waitrequest = (rd_cmd_left != 0) | rd_wr_hazard;
+assign us_rd_rdata = rd_sr;
+assign dn_rd_addr = dn_map(rd_cmd_addr);
+assign dn_rd_read = (rd_cmd_left != 0);
+assign dn_rd_burstcount = RATIO;
+
+always @(posedge clk or negedge reset_n) begin
+    if (!reset_n) begin
+        rd_sr <= 0;
+        rd_cmd_addr <= 0;
+        rd_cmd_left <= 0;
+        rd_word_cnt <= 0;
+        us_rd_readdatavalid <= 1'b0;
+    end else begin
+        if (us_rd_acc) begin
+            rd_cmd_addr <= us_rd_addr;
+            rd_cmd_left <= us_rd_burstcount;
+        end else if (dn_rd_acc) begin
+            rd_cmd_addr <= rd_cmd_addr + BEAT_BYTES;
+            rd_cmd_left <= rd_cmd_left - 1'b1;
+        end
+
+        // returned words arrive in command order, lowest word of each beat first
+        us_rd_readdatavalid <= dn_rd_readdatavalid & (rd_word_cnt == RATIO-1);
+        if (dn_rd_readdatavalid) begin
+            rd_sr <= {dn_rd_rdata, rd_sr[255:DN_DW]};
+            rd_word_cnt <= (rd_word_cnt == RATIO-1) ? 0 : rd_word_cnt + 1'b1;
+        end
+    end
+end
+
+endmodule
@@ -0,0 +1,51 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+// Counts rising edges of an asynchronous event flag in CLK_i domain. Counter wraps,
+// readers are expected to accumulate deltas.
+
+module pulse_counter #(
+    parameter CNT_WIDTH = 8
+  ) (
+    input CLK_i,
+    input reset_n,
+    input event_i,
+    output reg [CNT_WIDTH-1:0] cnt_o
+);
+
+reg event_sync1_reg, event_sync2_reg, event_prev;
+
+always @(posedge CLK_i or negedge reset_n) begin
+    if (!reset_n) begin
+        event_sync1_reg <= 1'b0;
+        event_sync2_reg <= 1'b0;
+        event_prev <= 1'b0;
+        cnt_o <= 0;
+    end else begin
+        event_sync1_reg <= event_i;
+        event_sync2_reg <= event_sync1_reg;
+        event_prev <= event_sync2_reg;
+
+        if (event_sync2_reg & ~event_prev)
+            cnt_o <= cnt_o + 1'b1;
+    end
+end
+
+endmodule
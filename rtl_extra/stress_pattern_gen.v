@@ -0,0 +1,90 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+// Pixel data override for benchmarking capture -> linebuffer/VIP -> output path. Sync and
+// pixel rate come from the selected capture source; only RGB data is replaced.
+//
+// mode: 0 = passthrough
+//       1 = full-motion noise (new LFSR sequence every frame)
+//       2 = alternating fields (line parity inverted every frame)
+//       3 = max transitions (1-pixel checkerboard inverted every frame)
+//       4 = vertical ramp scrolling one line per frame
+// A 16-bit frame counter is overlaid in binary (16x16 blocks, MSB first) at top-left for modes 1-4.
+
+module stress_pattern_gen (
+    input PCLK_i,
+    input reset_n,
+    input [2:0] mode,
+    input frame_change_i,
+    input datavalid_i,
+    input [10:0] xpos_i,
+    input [10:0] ypos_i,
+    input [7:0] R_i,
+    input [7:0] G_i,
+    input [7:0] B_i,
+    output reg [7:0] R_o,
+    output reg [7:0] G_o,
+    output reg [7:0] B_o
+);
+
+localparam OVERLAY_BLOCK_BITS = 4;
+
+reg [15:0] frame_ctr;
+reg [23:0] lfsr;
+reg frame_change_prev;
+
+wire overlay_active = (ypos_i < (1<<OVERLAY_BLOCK_BITS)) && (xpos_i < (16<<OVERLAY_BLOCK_BITS));
+wire overlay_bit = frame_ctr[4'hf - xpos_i[OVERLAY_BLOCK_BITS+:4]];
+wire [10:0] ramp_pos = ypos_i + frame_ctr[10:0];
+
+always @(posedge PCLK_i or negedge reset_n) begin
+    if (!reset_n) begin
+        frame_ctr <= 0;
+        lfsr <= 24'h1;
+        frame_change_prev <= 1'b0;
+    end else begin
+        frame_change_prev <= frame_change_i;
+
+        if (frame_change_i & ~frame_change_prev) begin
+            frame_ctr <= frame_ctr + 1'b1;
+            // reseed so that consecutive frames never match
+            lfsr <= {frame_ctr, 8'h5a};
+        end else if (datavalid_i) begin
+            // x^24 + x^23 + x^22 + x^17 + 1
+            lfsr <= {lfsr[22:0], lfsr[23]^lfsr[22]^lfsr[21]^lfsr[16]};
+        end
+    end
+end
+
+always @(*) begin
+    if ((mode != 3'h0) && overlay_active) begin
+        {R_o, G_o, B_o} = overlay_bit ? 24'hffffff : 24'h202020;
+    end else begin
+        case (mode)
+            3'h1: {R_o, G_o, B_o} = lfsr;
+            3'h2: {R_o, G_o, B_o} = (ypos_i[0] ^ frame_ctr[0]) ? 24'hffffff : 24'h000000;
+            3'h3: {R_o, G_o, B_o} = (xpos_i[0] ^ ypos_i[0] ^ frame_ctr[0]) ? 24'hffffff : 24'h000000;
+            3'h4: {R_o, G_o, B_o} = {ramp_pos[7:0], ramp_pos[8:1], ramp_pos[9:2]};
+            default: {R_o, G_o, B_o} = {R_i, G_i, B_i};
+        endcase
+    end
+end
+
+endmodule
@@ -0,0 +1,59 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+// RGB 4:4:4 -> YCbCr 4:2:2 packing for VIP input (2 pixels in parallel). Chroma is averaged
+// over the pixel pair so that VIP cores and frame buffer operate with 2 color planes.
+// Output pixel format is {Y, C} with Cb on pixel 0 and Cr on pixel 1. Full range BT.709.
+
+module vip_422_pack (
+    input [47:0] rgb_i,
+    output [31:0] ycbcr_o
+);
+
+wire [7:0] R0 = rgb_i[23:16];
+wire [7:0] G0 = rgb_i[15:8];
+wire [7:0] B0 = rgb_i[7:0];
+wire [7:0] R1 = rgb_i[47:40];
+wire [7:0] G1 = rgb_i[39:32];
+wire [7:0] B1 = rgb_i[31:24];
+
+// coefficients in Q8
+wire [15:0] Y0_q8 = 8'd54*R0 + 8'd183*G0 + 8'd19*B0;
+wire [15:0] Y1_q8 = 8'd54*R1 + 8'd183*G1 + 8'd19*B1;
+
+// chroma computed from the sum of both pixels (Q9 after pair sum)
+wire [8:0] R_sum = R0 + R1;
+wire [8:0] G_sum = G0 + G1;
+wire [8:0] B_sum = B0 + B1;
+wire [17:0] Cb_p = 18'd128*B_sum;
+wire [17:0] Cb_n = 18'd29*R_sum + 18'd99*G_sum;
+wire [17:0] Cr_p = 18'd128*R_sum;
+wire [17:0] Cr_n = 18'd116*G_sum + 18'd12*B_sum;
+wire signed [18:0] Cb_q9 = $signed({1'b0, Cb_p}) - $signed({1'b0, Cb_n});
+wire signed [18:0] Cr_q9 = $signed({1'b0, Cr_p}) - $signed({1'b0, Cr_n});
+
+wire [7:0] Y0 = Y0_q8[15:8] + Y0_q8[7];
+wire [7:0] Y1 = Y1_q8[15:8] + Y1_q8[7];
+wire [7:0] Cb = Cb_q9[16:9] + 8'd128;
+wire [7:0] Cr = Cr_q9[16:9] + 8'd128;
+
+assign ycbcr_o = {Y1, Cr, Y0, Cb};
+
+endmodule
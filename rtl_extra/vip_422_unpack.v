@@ -0,0 +1,54 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+// YCbCr 4:2:2 -> RGB 4:4:4 unpacking for VIP output (2 pixels in parallel). Chroma pair
+// is shared by both pixels. Inverse of vip_422_pack (full range BT.709).
+
+module vip_422_unpack (
+    input [31:0] ycbcr_i,
+    output [47:0] rgb_o
+);
+
+wire [7:0] Y0 = ycbcr_i[15:8];
+wire [7:0] Y1 = ycbcr_i[31:24];
+wire signed [8:0] Cb = $signed({1'b0, ycbcr_i[7:0]}) - 9'sd128;
+wire signed [8:0] Cr = $signed({1'b0, ycbcr_i[23:16]}) - 9'sd128;
+
+// chroma contributions in Q8
+wire signed [18:0] R_c = 10'sd403*Cr;
+wire signed [18:0] G_c = -(8'sd48*Cb) - (8'sd120*Cr);
+wire signed [18:0] B_c = 10'sd475*Cb;
+
+function [7:0] clamp;
+    input signed [18:0] v_q8;
+    begin
+        if (v_q8 < 0)
+            clamp = 8'h00;
+        else if (v_q8 > 19'sd65407)
+            clamp = 8'hff;
+        else
+            clamp = v_q8[15:8] + v_q8[7];
+    end
+endfunction
+
+assign rgb_o[23:0] = {clamp($signed({3'b0, Y0, 8'h0}) + R_c), clamp($signed({3'b0, Y0, 8'h0}) + G_c), clamp($signed({3'b0, Y0, 8'h0}) + B_c)};
+assign rgb_o[47:24] = {clamp($signed({3'b0, Y1, 8'h0}) + R_c), clamp($signed({3'b0, Y1, 8'h0}) + G_c), clamp($signed({3'b0, Y1, 8'h0}) + B_c)};
+
+endmodule
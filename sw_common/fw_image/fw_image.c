@@ -0,0 +1,112 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+// Host-side packer for in-firmware flash update (see sys_controller/fw_update.h). Takes the raw
+// programming data file (.rpd) generated from the board .cof, strips trailing erased bytes so that
+// untouched flash (e.g. user settings) is not rewritten and prepends header with image CRC.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stddef.h>
+#include "fw_update.h"
+#include "crc32.h"
+
+static const struct {
+    const char *name;
+    uint32_t id;
+} boards[] = {
+    { "c5g",        FW_UPDATE_BOARD_C5G },
+    { "de2-115",    FW_UPDATE_BOARD_DE2_115 },
+};
+#define NUM_BOARDS  (sizeof(boards)/sizeof(boards[0]))
+
+static void usage() {
+    fprintf(stderr, "Usage: fw_image <c5g|de2-115> <input.rpd> [output (default " FW_UPDATE_FILENAME ")]\n");
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    uint8_t hdr_buf[FW_UPDATE_HDR_SIZE];
+    fw_update_hdr_t *hdr = (fw_update_hdr_t*)hdr_buf;
+    const char *outname = FW_UPDATE_FILENAME;
+    uint8_t *img;
+    uint32_t size, padded;
+    long fsize;
+    unsigned i;
+    FILE *f;
+
+    if ((argc < 3) || (argc > 4))
+        usage();
+    if (argc == 4)
+        outname = argv[3];
+
+    memset(hdr_buf, 0, sizeof(hdr_buf));
+    for (i=0; i<NUM_BOARDS; i++) {
+        if (!strcmp(argv[1], boards[i].name))
+            hdr->board_id = boards[i].id;
+    }
+    if (!hdr->board_id)
+        usage();
+
+    if (!(f = fopen(argv[2], "rb")) || fseek(f, 0, SEEK_END) || ((fsize = ftell(f)) <= 0)) {
+        perror(argv[2]);
+        return 1;
+    }
+    rewind(f);
+    padded = ((uint32_t)fsize + FW_UPDATE_PAGE_SIZE - 1) & ~(FW_UPDATE_PAGE_SIZE - 1);
+    img = malloc(padded);
+    memset(img, 0xff, padded);
+    if (fread(img, 1, fsize, f) != (size_t)fsize) {
+        perror(argv[2]);
+        return 1;
+    }
+    fclose(f);
+
+    // .rpd covers the whole device, but only data up to last non-erased page needs to be written
+    for (size = padded; (size > 0) && (img[size-1] == 0xff); size--) ;
+    size = (size + FW_UPDATE_PAGE_SIZE - 1) & ~(FW_UPDATE_PAGE_SIZE - 1);
+    if (size == 0) {
+        fprintf(stderr, "%s: image is empty\n", argv[2]);
+        return 1;
+    }
+
+    hdr->magic = FW_UPDATE_MAGIC;
+    hdr->version = FW_UPDATE_VERSION;
+    hdr->hdr_size = FW_UPDATE_HDR_SIZE;
+    hdr->flash_offset = 0;
+    hdr->image_size = size;
+    hdr->image_crc = crc32_update(CRC32_INIT, img, size) ^ 0xffffffff;
+    hdr->hdr_crc = crc32_update(CRC32_INIT, hdr_buf, offsetof(fw_update_hdr_t, hdr_crc)) ^ 0xffffffff;
+
+    if (!(f = fopen(outname, "wb")) ||
+        (fwrite(hdr_buf, 1, FW_UPDATE_HDR_SIZE, f) != FW_UPDATE_HDR_SIZE) ||
+        (fwrite(img, 1, size, f) != size) ||
+        fclose(f)) {
+        perror(outname);
+        return 1;
+    }
+
+    printf("%s: %s, %u bytes, crc 0x%.8x\n", outname, argv[1], size, hdr->image_crc);
+    free(img);
+
+    return 0;
+}
@@ -0,0 +1,117 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+// Checks bounded-denominator approximation of si_ratio.c against exhaustive search over all
+// denominators, for random ratios in the range si_ratio_search() feeds it and with the
+// denominator limit in effect. Also checks that a few common framelock ratios are found exactly.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "si_ratio.c"
+
+#define NUM_RANDOM  300
+#define QMAX_SMALL  1000
+
+typedef unsigned __int128 u128;
+
+static uint64_t rand64() {
+    return ((uint64_t)rand() << 42) ^ ((uint64_t)rand() << 21) ^ (uint64_t)rand();
+}
+
+static u128 absdiff128(u128 a, u128 b) {
+    return (a > b) ? a-b : b-a;
+}
+
+// Returns nonzero if |n/d - p1/q1| < |n/d - p2/q2|
+static int closer(uint64_t n, uint64_t d, uint64_t p1, uint64_t q1, uint64_t p2, uint64_t q2) {
+    return absdiff128((u128)n*q1, (u128)p1*d)*q2 < absdiff128((u128)n*q2, (u128)p2*d)*q1;
+}
+
+static void brute_rational(uint64_t n, uint64_t d, uint32_t qmax, uint64_t *p, uint64_t *q) {
+    uint64_t pc, qc;
+
+    *p = n/d;
+    *q = 1;
+    for (qc=1; qc<=qmax; qc++) {
+        pc = (uint64_t)(((u128)n*qc + d/2) / d);
+        if (closer(n, d, pc, qc, *p, *q)) {
+            *p = pc;
+            *q = qc;
+        }
+    }
+}
+
+static int check_rational(uint64_t n, uint64_t d, uint32_t qmax) {
+    uint64_t p, q, bp, bq;
+
+    best_rational(n, d, qmax, &p, &q);
+    brute_rational(n, d, qmax, &bp, &bq);
+
+    if ((q == 0) || (q > qmax) || closer(n, d, bp, bq, p, q)) {
+        printf("%llu/%llu (qmax %u): got %llu/%llu, best %llu/%llu\n", (unsigned long long)n, (unsigned long long)d,
+               qmax, (unsigned long long)p, (unsigned long long)q, (unsigned long long)bp, (unsigned long long)bq);
+        return 1;
+    }
+
+    return 0;
+}
+
+typedef struct {
+    uint32_t clkin_hz;
+    uint32_t num;
+    uint32_t den;
+} exact_case_t;
+
+static const exact_case_t exact_cases[] = {
+    {27000000, 11, 4},          // 27MHz -> 74.25MHz
+    {25175000, 1001, 1000},
+    {74250000, 1, 1},           // CLKIN_DIV=1
+    {148500000, 1, 2},          // CLKIN_DIV=2
+};
+
+int main() {
+    si_ratio_t r;
+    uint64_t n, d;
+    uint32_t qmax;
+    int i, fail = 0;
+
+    srand(1);
+
+    for (i=0; i<NUM_RANDOM; i++) {
+        // num*d or den*m, and den or num
+        d = (rand64() % 0xffffffffULL) + 1;
+        n = d*(SI_RATIO_PLL_MIN + rand() % (SI_RATIO_PLL_MAX - SI_RATIO_PLL_MIN)) + rand64() % d;
+        qmax = (i & 1) ? SI_RATIO_DENOM_MAX : QMAX_SMALL;
+        if (d <= qmax)
+            d += qmax;
+        fail += check_rational(n, d, qmax);
+    }
+
+    for (i=0; i<sizeof(exact_cases)/sizeof(exact_case_t); i++) {
+        if ((si_ratio_search(exact_cases[i].clkin_hz, exact_cases[i].num, exact_cases[i].den, &r) != 0) || !r.exact) {
+            printf("%u*%u/%u: no exact configuration found\n", exact_cases[i].clkin_hz, exact_cases[i].num, exact_cases[i].den);
+            fail++;
+        }
+    }
+
+    printf("si_ratio_test: %s (%d failures)\n", fail ? "FAILED" : "PASSED", fail);
+
+    return fail ? 1 : 0;
+}
@@ -0,0 +1,3 @@
+// Build configuration for HAL backend builds
+
+#define HOST_CMD_ENABLE
@@ -0,0 +1,12 @@
+// Subset of DE10-Nano BSP system.h (Nios2 data master map) needed by the HAL-only modules.
+// On HPS the same offsets are reached through h2f_lw_axi_master, see HAL_MMIO_ADDR.
+
+#define ALT_CPU_FREQ 27000000
+#define TIMER_0_FREQ 27000000
+
+#define JTAG_UART_0_BASE 0x841eb8
+#define PIO_0_BASE 0x841ea0
+#define PIO_1_BASE 0x841e90
+#define CTRL_EVENT_FIFO_0_BASE 0x841ec0
+#define I2C_OPENCORES_0_BASE 0x841e60
+#define I2C_OPENCORES_1_BASE 0x841e40
@@ -0,0 +1,98 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+
+// Host-side dump of InfoFrames built by sys_controller/hdmi_pkt.c, byte for byte as written into
+// TX packet memory, and checksum check for packets captured with an HDMI analyzer.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "hdmi_pkt.h"
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s vsif <allm>\n", prog);
+    fprintf(stderr, "       %s avi <itc> <cn> [hb0 hb1 hb2 pb0 pb1...]\n", prog);
+    fprintf(stderr, "       %s check <hb0> <hb1> <hb2> <pb0> <pb1>...\n", prog);
+}
+
+static int parse_bytes(hdmi_infoframe_t *f, int argc, char **argv) {
+    int i;
+
+    if (argc > HDMI_IF_HB_LEN+HDMI_IF_PB_LEN)
+        return -1;
+
+    memset(f, 0, sizeof(hdmi_infoframe_t));
+    for (i=0; i<argc; i++) {
+        if (i < HDMI_IF_HB_LEN)
+            f->hb[i] = strtoul(argv[i], NULL, 16);
+        else
+            f->pb[i-HDMI_IF_HB_LEN] = strtoul(argv[i], NULL, 16);
+    }
+
+    return 0;
+}
+
+static void print_if(const hdmi_infoframe_t *f) {
+    int i;
+
+    for (i=0; i<HDMI_IF_HB_LEN; i++)
+        printf("%.2x ", f->hb[i]);
+    for (i=0; i<=f->hb[2] && i<HDMI_IF_PB_LEN; i++)
+        printf("%.2x ", f->pb[i]);
+    printf("\nchecksum %s\n", hdmi_if_checksum_ok(f) ? "ok" : "FAIL");
+}
+
+int main(int argc, char **argv) {
+    hdmi_infoframe_t f;
+
+    if (argc < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (!strcmp(argv[1], "vsif") && (argc == 3)) {
+        hdmi_pkt_hf_vsif(&f, strtoul(argv[2], NULL, 0));
+    } else if (!strcmp(argv[1], "avi") && (argc >= 4)) {
+        if (parse_bytes(&f, argc-4, argv+4) != 0) {
+            usage(argv[0]);
+            return 1;
+        }
+        if (argc == 4) {
+            f.hb[0] = HDMI_IF_TYPE_AVI;
+            f.hb[1] = HDMI_AVI_VERSION;
+            f.hb[2] = HDMI_AVI_LEN;
+        }
+        hdmi_pkt_avi_set_content_type(&f, strtoul(argv[2], NULL, 0), strtoul(argv[3], NULL, 0));
+    } else if (!strcmp(argv[1], "check") && (argc > 5)) {
+        if (parse_bytes(&f, argc-2, argv+2) != 0) {
+            usage(argv[0]);
+            return 1;
+        }
+    } else {
+        usage(argv[0]);
+        return 1;
+    }
+
+    print_if(&f);
+
+    return !hdmi_if_checksum_ok(&f);
+}
@@ -0,0 +1,124 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+
+// Known-answer test for InfoFrame builders and checksum. Expected bytes are computed by hand from
+// HDMI 2.1 (HF-VSIF) and CEA-861-F (AVI) field definitions.
+
+#include <stdio.h>
+#include <string.h>
+#include "hdmi_pkt.h"
+
+typedef struct {
+    const char *name;
+    uint8_t len;    // header + PB0..PB[length]
+    uint8_t v[HDMI_IF_HB_LEN+HDMI_IF_PB_LEN];
+} kat_t;
+
+static const kat_t vsif_allm_on =  {"HF-VSIF ALLM=1", 9, {0x81, 0x01, 0x05, 0x7d, 0xd8, 0x5d, 0xc4, 0x01, 0x02}};
+static const kat_t vsif_allm_off = {"HF-VSIF ALLM=0", 9, {0x81, 0x01, 0x05, 0x7f, 0xd8, 0x5d, 0xc4, 0x01, 0x00}};
+
+// 1080p60 RGB, 16:9, active format = same as picture
+static const kat_t avi_base =      {"AVI VIC16", 17, {0x82, 0x02, 0x0d, 0x25, 0x12, 0x28, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}};
+static const kat_t avi_game =      {"AVI VIC16 ITC=1 CN=Game", 17, {0x82, 0x02, 0x0d, 0x75, 0x12, 0x28, 0x80, 0x10, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}};
+static const kat_t avi_photo =     {"AVI VIC16 ITC=1 CN=Photo", 17, {0x82, 0x02, 0x0d, 0x95, 0x12, 0x28, 0x80, 0x10, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}};
+
+static void load_kat(hdmi_infoframe_t *f, const kat_t *k) {
+    memset(f, 0, sizeof(hdmi_infoframe_t));
+    memcpy(f->hb, k->v, HDMI_IF_HB_LEN);
+    memcpy(f->pb, k->v+HDMI_IF_HB_LEN, k->len-HDMI_IF_HB_LEN);
+}
+
+static int check_frame(const char *step, const hdmi_infoframe_t *f, const kat_t *k) {
+    hdmi_infoframe_t ref;
+    int i;
+
+    load_kat(&ref, k);
+
+    if (memcmp(f, &ref, sizeof(hdmi_infoframe_t)) != 0) {
+        printf("%s (%s): mismatch\n  got ", step, k->name);
+        for (i=0; i<k->len; i++)
+            printf("%.2x ", (i < HDMI_IF_HB_LEN) ? f->hb[i] : f->pb[i-HDMI_IF_HB_LEN]);
+        printf("\n  exp ");
+        for (i=0; i<k->len; i++)
+            printf("%.2x ", k->v[i]);
+        printf("\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+static int check_checksum(const kat_t *k) {
+    hdmi_infoframe_t f;
+    int fails = 0;
+
+    load_kat(&f, k);
+
+    if (hdmi_if_checksum(&f) != k->v[HDMI_IF_HB_LEN]) {
+        printf("checksum (%s): got %.2x exp %.2x\n", k->name, hdmi_if_checksum(&f), k->v[HDMI_IF_HB_LEN]);
+        fails++;
+    }
+    if (!hdmi_if_checksum_ok(&f)) {
+        printf("checksum_ok (%s): valid frame rejected\n", k->name);
+        fails++;
+    }
+
+    // any single payload bit error must be detected
+    f.pb[1] ^= 0x01;
+    if (hdmi_if_checksum_ok(&f)) {
+        printf("checksum_ok (%s): corrupted frame accepted\n", k->name);
+        fails++;
+    }
+
+    return fails;
+}
+
+int main() {
+    hdmi_infoframe_t f;
+    int fails = 0;
+
+    fails += check_checksum(&vsif_allm_on);
+    fails += check_checksum(&vsif_allm_off);
+    fails += check_checksum(&avi_base);
+    fails += check_checksum(&avi_game);
+    fails += check_checksum(&avi_photo);
+
+    hdmi_pkt_hf_vsif(&f, 1);
+    fails += check_frame("hf_vsif", &f, &vsif_allm_on);
+    hdmi_pkt_hf_vsif(&f, 0);
+    fails += check_frame("hf_vsif", &f, &vsif_allm_off);
+
+    load_kat(&f, &avi_base);
+    hdmi_pkt_avi_set_content_type(&f, 1, HDMI_CN_GAME);
+    fails += check_frame("avi_set_content_type", &f, &avi_game);
+
+    // content type change keeps ITC and other PB3/PB5 fields
+    hdmi_pkt_avi_set_content_type(&f, 1, HDMI_CN_PHOTO);
+    fails += check_frame("avi_set_content_type", &f, &avi_photo);
+
+    // disabling game mode restores the original frame
+    hdmi_pkt_avi_set_content_type(&f, 0, HDMI_CN_GRAPHICS);
+    fails += check_frame("avi_set_content_type", &f, &avi_base);
+
+    printf("%s (%d failures)\n", fails ? "FAILED" : "PASSED", fails);
+
+    return fails ? 1 : 0;
+}
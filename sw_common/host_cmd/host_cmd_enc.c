@@ -0,0 +1,118 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+// Host-side encoder for firmware command frames (see sys_controller/host_cmd.h). Writes one
+// frame to stdout, e.g. into nios2-terminal input. Replies come back as CMD_REPLY records
+// which are printed by trace_decode.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "host_cmd.h"
+
+typedef struct {
+    const char *name;
+    uint8_t id;
+    const char *args;       // size of each argument in bytes, '*' repeats last one
+    const char *help;
+} cmd_def_t;
+
+static const cmd_def_t cmd_defs[] = {
+    {"ping",    HOST_CMD_PING,          "",     ""},
+    {"input",   HOST_CMD_SET_INPUT,     "1",    "<avinput>"},
+    {"profile", HOST_CMD_LOAD_PROFILE,  "1",    "<slot>"},
+    {"avcfg",   HOST_CMD_WR_AVCONFIG,   "21*",  "<offset> <byte>..."},
+    {"rdobj",   HOST_CMD_RD_OBJ,        "12",   "<object> <word offset>"},
+    {"setvar",  HOST_CMD_SET_VAR,       "14",   "<var> <value>"},
+    {"getvar",  HOST_CMD_GET_VAR,       "1",    "<var>"},
+    {"relock",  HOST_CMD_RELOCK,        "",     ""},
+};
+
+#define NUM_CMDS (sizeof(cmd_defs)/sizeof(cmd_defs[0]))
+
+static void usage(const char *prog) {
+    unsigned i;
+
+    fprintf(stderr, "usage: %s [-s seq] <command> [args]\n", prog);
+    for (i=0; i<NUM_CMDS; i++)
+        fprintf(stderr, "  %-8s %s\n", cmd_defs[i].name, cmd_defs[i].help);
+}
+
+int main(int argc, char **argv) {
+    uint8_t frame[HOST_CMD_HDR_LEN+HOST_CMD_MAX_PAYLOAD+1];
+    const cmd_def_t *def = NULL;
+    const char *a;
+    unsigned long val;
+    unsigned seq = 0, len = 0, i, n, argi = 1, nargs;
+    uint8_t sum = 0;
+
+    if ((argc > 2) && !strcmp(argv[1], "-s")) {
+        seq = strtoul(argv[2], NULL, 0);
+        argi = 3;
+    }
+    if (argi >= (unsigned)argc) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    for (i=0; i<NUM_CMDS; i++) {
+        if (!strcmp(argv[argi], cmd_defs[i].name))
+            def = &cmd_defs[i];
+    }
+    if (!def) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    nargs = argc - (argi+1);
+    if (nargs < strcspn(def->args, "*")) {
+        fprintf(stderr, "missing arguments\n");
+        return 1;
+    }
+
+    for (a=def->args, argi++; argi<(unsigned)argc; argi++) {
+        if (!*a) {
+            fprintf(stderr, "too many arguments\n");
+            return 1;
+        }
+        n = *a - '0';
+        if (len + n > HOST_CMD_MAX_PAYLOAD) {
+            fprintf(stderr, "payload too long\n");
+            return 1;
+        }
+        val = strtoul(argv[argi], NULL, 0);
+        for (i=0; i<n; i++)
+            frame[HOST_CMD_HDR_LEN+len++] = (val >> (8*i)) & 0xff;
+        if (a[1] != '*')
+            a++;
+    }
+    frame[0] = HOST_CMD_SYNC_BYTE;
+    frame[1] = def->id;
+    frame[2] = seq;
+    frame[3] = len;
+    for (i=1; i<HOST_CMD_HDR_LEN+len; i++)
+        sum += frame[i];
+    frame[HOST_CMD_HDR_LEN+len] = -sum;
+
+    fwrite(frame, 1, HOST_CMD_HDR_LEN+len+1, stdout);
+
+    return 0;
+}
@@ -0,0 +1,225 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+// Host-side mode planner. Runs the firmware mode selection logic (get_operating_mode(),
+// calculate_pclk(), estimate_dotclk()) for every input timing x processing setting and
+// prints the resulting configuration, pixel clocks against SDC limits, estimated DDR
+// bandwidth and latency as CSV. The matrix is split into contiguous chunks processed by
+// forked workers (firmware code uses globals so threads are not an option).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "sysconfig.h"
+#include "avconfig.h"
+#include "video_modes.h"
+#include "int_scale.h"
+#include "frame_mult.h"
+
+#define SI_XTAL_HZ          27000000UL
+#define PCLK_CAPTURE_MAX_HZ 108000000UL     // pclk_isl constraint
+#define PCLK_OUT_MAX_HZ     200000000UL     // pclk_si constraint
+#ifdef VIP_422
+#define DDR_BYTES_PER_PIXEL 2
+#else
+#define DDR_BYTES_PER_PIXEL 3
+#endif
+
+#ifndef PLANNER_NUM_LM_MULT
+#define PLANNER_NUM_LM_MULT 6
+#endif
+#ifndef PLANNER_NUM_SCL_OUT_MODES
+#define PLANNER_NUM_SCL_OUT_MODES 16
+#endif
+
+typedef struct {
+    const char *name;
+    uint16_t v_total;
+    uint16_t v_hz_x100;
+    uint16_t h_synclen;
+    uint8_t interlaced;
+} planner_input_t;
+
+// Measured sync parameters as reported by ISL51002 for common sources
+static const planner_input_t planner_inputs[] = {
+    { "240p60",     262,    6005,   18, 0 },
+    { "240p60_263", 263,    5994,   18, 0 },
+    { "288p50",     312,    5008,   18, 0 },
+    { "288p50_313", 313,    5003,   18, 0 },
+    { "384p55",     410,    5500,   32, 0 },
+    { "480i60",     525,    5994,   64, 1 },
+    { "576i50",     625,    5000,   64, 1 },
+    { "480p60",     525,    5994,   62, 0 },
+    { "576p50",     625,    5000,   64, 0 },
+    { "720p60",     750,    6000,   40, 0 },
+    { "720p50",     750,    5000,   40, 0 },
+    { "1080i60",    1125,   6000,   44, 1 },
+    { "1080i50",    1125,   5000,   44, 1 },
+    { "1080p60",    1125,   6000,   44, 0 },
+    { "1080p50",    1125,   5000,   44, 0 },
+    { "VGA640x480", 525,    5994,   96, 0 },
+    { "SVGA800x600",628,    6032,   128,0 },
+    { "XGA1024x768",806,    6000,   136,0 },
+};
+#define NUM_PLANNER_INPUTS  (sizeof(planner_inputs)/sizeof(planner_inputs[0]))
+
+typedef enum {
+    CFG_PURE_LM,
+    CFG_ADAPT_LM,
+    CFG_SCALER,
+} planner_cfg_type_t;
+
+#define NUM_LM_CFGS         (2*PLANNER_NUM_LM_MULT)
+#define NUM_CFGS            (NUM_LM_CFGS+PLANNER_NUM_SCL_OUT_MODES)
+#define NUM_ENTRIES         (NUM_PLANNER_INPUTS*NUM_CFGS)
+
+static void apply_cfg(avconfig_t *cfg, int cfg_idx, planner_cfg_type_t *type, int *param) {
+    if (cfg_idx < NUM_LM_CFGS) {
+        *type = (cfg_idx < PLANNER_NUM_LM_MULT) ? CFG_PURE_LM : CFG_ADAPT_LM;
+        *param = cfg_idx % PLANNER_NUM_LM_MULT;
+        cfg->oper_mode = 0;
+        cfg->lm_mode = (*type == CFG_ADAPT_LM);
+        cfg->pm_240p = cfg->pm_384p = cfg->pm_480i = cfg->pm_480p = cfg->pm_1080i = *param;
+        cfg->pm_ad_240p = cfg->pm_ad_288p = cfg->pm_ad_384p = cfg->pm_ad_480i = cfg->pm_ad_576i = cfg->pm_ad_480p = cfg->pm_ad_576p = *param;
+    } else {
+        *type = CFG_SCALER;
+        *param = cfg_idx - NUM_LM_CFGS;
+        cfg->oper_mode = 1;
+        cfg->scl_out_mode = *param;
+    }
+}
+
+static void plan_entry(FILE *out, int idx) {
+    static const char *cfg_str[] = {"pure_lm", "adapt_lm", "scaler"};
+    const planner_input_t *in = &planner_inputs[idx / NUM_CFGS];
+    avconfig_t *cfg = get_current_avconfig();
+    mode_data_t vmode_in, vmode_out;
+    vm_proc_config_t vm_conf;
+    planner_cfg_type_t cfg_type;
+    oper_mode_t oper_mode;
+    uint32_t h_hz, pll_h_total, pclk_i_hz, pclk_o_hz, dotclk_hz, frame_bytes, ddr_mbps, latency_lines;
+    int cfg_param;
+
+    set_default_avconfig(1);
+    apply_cfg(cfg, idx % NUM_CFGS, &cfg_type, &cfg_param);
+
+    // same fields as filled from ISL sync measurements in mainloop
+    memset(&vmode_in, 0, sizeof(mode_data_t));
+    memset(&vmode_out, 0, sizeof(mode_data_t));
+    memset(&vm_conf, 0, sizeof(vm_proc_config_t));
+    vmode_in.timings.v_hz_x100 = in->v_hz_x100;
+    vmode_in.timings.h_synclen = in->h_synclen;
+    vmode_in.timings.v_total = in->v_total;
+    vmode_in.timings.interlaced = in->interlaced;
+    h_hz = ((uint64_t)in->v_hz_x100*in->v_total)/(100*(1+in->interlaced));
+
+    oper_mode = get_operating_mode(cfg, &vmode_in, &vmode_out, &vm_conf);
+    oper_mode = int_scale_select(cfg, oper_mode, &vmode_in, &vmode_out, &vm_conf);
+    oper_mode = frame_mult_select(oper_mode, &vmode_in, &vmode_out, &vm_conf);
+
+    if (oper_mode == OPERMODE_INVALID) {
+        fprintf(out, "%s,%s,%d,invalid,,,,,,,,,,,,\n", in->name, cfg_str[cfg_type], cfg_param);
+        return;
+    }
+
+    pll_h_total = (vm_conf.h_skip+1) * vmode_in.timings.h_total + (((vm_conf.h_skip+1) * vmode_in.timings.h_total_adj * 5 + 50) / 100);
+    pclk_i_hz = h_hz * pll_h_total;
+    dotclk_hz = estimate_dotclk(&vmode_in, h_hz);
+    pclk_o_hz = calculate_pclk(vm_conf.framelock ? pclk_i_hz : SI_XTAL_HZ, &vmode_out, &vm_conf);
+
+    // Active frame size as stored by VIP/EMIF linebuffer
+    frame_bytes = (uint32_t)vmode_in.timings.h_active * (vmode_in.timings.v_active << vmode_in.timings.interlaced) * DDR_BYTES_PER_PIXEL;
+    if (oper_mode == OPERMODE_SCALER) {
+        // VFB write at input rate and read at output rate, deinterlacer reads previous fields and motion data
+        ddr_mbps = ((uint64_t)frame_bytes*vmode_in.timings.v_hz_x100/(100*(1+in->interlaced)) +
+                    (uint64_t)frame_bytes*vmode_out.timings.v_hz_x100/100 +
+                    (in->interlaced ? 3ULL*frame_bytes*vmode_in.timings.v_hz_x100/200 : 0)) / 1000000;
+        latency_lines = vmode_in.timings.v_total + (in->interlaced ? vmode_in.timings.v_total/2 : 0);
+    } else if (oper_mode == OPERMODE_ADAPT_LM) {
+        // each line written once and read once per output frame through EMIF linebuffer
+        ddr_mbps = ((1ULL+(frame_mult_active ? frame_mult_active : 1))*frame_bytes*vmode_in.timings.v_hz_x100/(100*(1+in->interlaced))) / 1000000;
+        latency_lines = 1 + vm_conf.framesync_line;
+    } else {
+        ddr_mbps = 0;
+        latency_lines = 1;
+    }
+
+    fprintf(out, "%s,%s,%d,%s,%s,%u,%u,%u,%lu,%lu,%lu,%d,%s,%s,%lu,%lu\n",
+            in->name, cfg_str[cfg_type], cfg_param,
+            (oper_mode == OPERMODE_SCALER) ? "scaler" : ((oper_mode == OPERMODE_ADAPT_LM) ? "adapt_lm" : "pure_lm"), vmode_out.name,
+            vm_conf.framelock, vm_conf.h_skip, pll_h_total,
+            (unsigned long)pclk_i_hz, (unsigned long)dotclk_hz, (unsigned long)pclk_o_hz, vm_conf.si_pclk_mult,
+            (pclk_i_hz <= PCLK_CAPTURE_MAX_HZ) ? "ok" : "OVER",
+            (pclk_o_hz <= PCLK_OUT_MAX_HZ) ? "ok" : "OVER",
+            (unsigned long)ddr_mbps, (unsigned long)latency_lines);
+}
+
+int main(int argc, char **argv) {
+    long num_workers = sysconf(_SC_NPROCESSORS_ONLN);
+    FILE **chunk_out;
+    pid_t *pids;
+    char buf[4096];
+    size_t n;
+    int i, idx, status, retval = 0;
+
+    if (argc > 1)
+        num_workers = strtol(argv[1], NULL, 10);
+    if (num_workers < 1)
+        num_workers = 1;
+
+    chunk_out = calloc(num_workers, sizeof(FILE*));
+    pids = calloc(num_workers, sizeof(pid_t));
+
+    for (i=0; i<num_workers; i++) {
+        chunk_out[i] = tmpfile();
+        if (chunk_out[i] == NULL) {
+            perror("tmpfile");
+            return 1;
+        }
+        pids[i] = fork();
+        if (pids[i] < 0) {
+            perror("fork");
+            return 1;
+        } else if (pids[i] == 0) {
+            for (idx=(i*NUM_ENTRIES)/num_workers; idx<((i+1)*NUM_ENTRIES)/num_workers; idx++)
+                plan_entry(chunk_out[i], idx);
+            fflush(chunk_out[i]);
+            _exit(0);
+        }
+    }
+
+    fputs("input,config,param,opermode,output,framelock,h_skip,pll_h_total,pclk_in_hz,dotclk_hz,pclk_out_hz,si_pclk_mult,pclk_in_limit,pclk_out_limit,ddr_mbps,latency_lines\n", stdout);
+
+    // concatenate in worker order so that output is deterministic
+    for (i=0; i<num_workers; i++) {
+        if ((waitpid(pids[i], &status, 0) < 0) || !WIFEXITED(status) || WEXITSTATUS(status)) {
+            fprintf(stderr, "worker %d failed\n", i);
+            retval = 1;
+        }
+        rewind(chunk_out[i]);
+        while ((n = fread(buf, 1, sizeof(buf), chunk_out[i])) > 0)
+            fwrite(buf, 1, n, stdout);
+        fclose(chunk_out[i]);
+    }
+
+    return retval;
+}
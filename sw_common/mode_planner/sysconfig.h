@@ -0,0 +1,19 @@
+#ifndef SYSCONFIG_H_
+#define SYSCONFIG_H_
+
+// Host build configuration for mode planner (matches C5G/DE10-Nano feature set)
+
+#define DExx_FW
+#define INC_ADV7513
+#define VIP
+#define VIP_DIL_B
+#define FRAME_MULT_MAX 4
+
+#define OS_PRINTF(...)
+#define ErrorF(...)
+#define printf(...)
+#define sniprintf snprintf
+
+#define MAINLOOP_INTERVAL_US   10000
+
+#endif /* SYSCONFIG_H_ */
@@ -0,0 +1,6 @@
+#ifndef SYSCONFIG_H_
+#define SYSCONFIG_H_
+
+// Host build configuration for scaler coefficient generator test (default cache size)
+
+#endif /* SYSCONFIG_H_ */
@@ -0,0 +1,31 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef CRC32_H_
+#define CRC32_H_
+
+#include <stdint.h>
+
+#define CRC32_INIT  0xffffffff
+
+// Reflected CRC-32 (IEEE 802.3, same as zlib). Start from CRC32_INIT and invert the final value.
+uint32_t crc32_update(uint32_t crc, const uint8_t *buf, uint32_t len);
+
+#endif /* CRC32_H_ */
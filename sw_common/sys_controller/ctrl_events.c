@@ -0,0 +1,246 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include <string.h>
+#include "ctrl_events.h"
+#include "hal.h"
+#include "trace.h"
+#if !defined(HAL_HPS) && !defined(HAL_HOST)
+#include "sys/alt_irq.h"
+#define CTRL_EVT_USE_IRQ
+#endif
+
+#ifdef CTRL_EVENT_FIFO_0_BASE
+
+#define CTRL_EVT_RD(reg)        IORD(CTRL_EVENT_FIFO_0_BASE, reg)
+#define CTRL_EVT_WR(reg, data)  IOWR(CTRL_EVENT_FIFO_0_BASE, reg, data)
+
+// single producer (ISR / drain) and single consumer (main loop)
+static ctrl_event_t ring[CTRL_EVT_RING_SIZE];
+static volatile uint8_t ring_wr, ring_rd;
+
+static ctrl_events_stats_t stats;
+static uint32_t ctrl_reg;
+static uint32_t last_word, pending_word;
+static uint8_t pending;
+static volatile uint8_t irq_masked;
+
+static uint16_t ir_code;
+static uint8_t ir_rpt;
+static uint32_t ir_press_ts, ir_frame_ts, ir_emit_ts;
+static uint8_t ir_held;
+
+// events in [skip_from, skip_to) were seen live while override had expired
+static uint32_t skip_from, skip_to;
+static uint8_t skip_valid;
+
+#define TS_BEFORE(a, b)     ((int32_t)((a)-(b)) < 0)
+
+void ctrl_events_drain() {
+    uint32_t status = CTRL_EVT_RD(CTRL_EVT_REG_CTRL);
+    uint8_t level = status & CTRL_EVT_LEVEL_MASK;
+    uint8_t next;
+
+    if (status & CTRL_EVT_OVERFLOW) {
+        stats.hw_overflows++;
+        CTRL_EVT_WR(CTRL_EVT_REG_CTRL, ctrl_reg|CTRL_EVT_OVERFLOW);
+    }
+
+    while (level--) {
+        next = (ring_wr + 1) % CTRL_EVT_RING_SIZE;
+        if (next == ring_rd) {
+            // keep hardware FIFO as backlog until main loop catches up
+            stats.ring_overflows++;
+            break;
+        }
+        ring[ring_wr].ts = CTRL_EVT_RD(CTRL_EVT_REG_EVT_TS);
+        ring[ring_wr].evt = CTRL_EVT_RD(CTRL_EVT_REG_EVT);
+        TRACE2(CTRL_EVENT, ring[ring_wr].evt, ring[ring_wr].ts);
+        ring_wr = next;
+        stats.events++;
+    }
+}
+
+#ifdef CTRL_EVT_USE_IRQ
+static void ctrl_events_isr(void *context) {
+    ctrl_events_drain();
+
+    // mask interrupt until main loop frees ring space
+    if (((ring_wr + 1) % CTRL_EVT_RING_SIZE) == ring_rd) {
+        irq_masked = 1;
+        CTRL_EVT_WR(CTRL_EVT_REG_CTRL, (ctrl_reg & ~CTRL_EVT_IRQ_EN));
+    }
+}
+#endif
+
+void ctrl_events_init() {
+    memset(&stats, 0, sizeof(stats));
+    ring_wr = ring_rd = 0;
+    ir_held = 0;
+    skip_valid = 0;
+    pending = 0;
+    irq_masked = 0;
+
+    last_word = hal_pio_rd(PIO_1_BASE);
+    CTRL_EVT_WR(CTRL_EVT_REG_OVR, last_word);
+
+    // flush events captured before init
+    while (CTRL_EVT_RD(CTRL_EVT_REG_CTRL) & CTRL_EVT_LEVEL_MASK)
+        (void)CTRL_EVT_RD(CTRL_EVT_REG_EVT);
+
+    ctrl_reg = CTRL_EVT_OVR_EN;
+#ifdef CTRL_EVT_USE_IRQ
+    ctrl_reg |= CTRL_EVT_IRQ_EN;
+    alt_ic_isr_register(CTRL_EVENT_FIFO_0_IRQ_INTERRUPT_CONTROLLER_ID, CTRL_EVENT_FIFO_0_IRQ, ctrl_events_isr, NULL, NULL);
+#endif
+    CTRL_EVT_WR(CTRL_EVT_REG_CTRL, ctrl_reg|CTRL_EVT_OVERFLOW|CTRL_EVT_OVR_EXPIRED);
+}
+
+void ctrl_events_override(int enable) {
+    if (enable) {
+        last_word = hal_pio_rd(PIO_1_BASE);
+        CTRL_EVT_WR(CTRL_EVT_REG_OVR, last_word);
+        ctrl_reg |= CTRL_EVT_OVR_EN;
+        // everything captured meanwhile was handled by the caller from live inputs
+#ifndef CTRL_EVT_USE_IRQ
+        ctrl_events_drain();
+#endif
+        ring_rd = ring_wr;
+        ir_held = 0;
+        pending = 0;
+    } else {
+        ctrl_reg &= ~CTRL_EVT_OVR_EN;
+    }
+    CTRL_EVT_WR(CTRL_EVT_REG_CTRL, ctrl_reg);
+}
+
+static void check_expiry() {
+    uint32_t status = CTRL_EVT_RD(CTRL_EVT_REG_CTRL);
+
+    if (!(status & CTRL_EVT_OVR_EXPIRED))
+        return;
+
+    // Some code polled live inputs while main loop was blocked. Resume from the live
+    // state and skip events that occurred while the override was inactive.
+    skip_from = CTRL_EVT_RD(CTRL_EVT_REG_EXP_TS);
+    ctrl_events_replay(hal_pio_rd(PIO_1_BASE));
+    skip_to = CTRL_EVT_RD(CTRL_EVT_REG_TIME);
+    skip_valid = 1;
+    ir_held = 0;
+    CTRL_EVT_WR(CTRL_EVT_REG_CTRL, ctrl_reg|CTRL_EVT_OVR_EXPIRED);
+}
+
+int ctrl_events_next(uint32_t *controls) {
+    ctrl_event_t e;
+    uint32_t now;
+    uint16_t code;
+    uint8_t cnt;
+
+#ifndef CTRL_EVT_USE_IRQ
+    ctrl_events_drain();
+#endif
+    check_expiry();
+
+    if (pending) {
+        pending = 0;
+        last_word = pending_word;
+        *controls = last_word;
+        stats.replayed++;
+        return 1;
+    }
+
+    while (ring_rd != ring_wr) {
+        e = ring[ring_rd];
+        ring_rd = (ring_rd + 1) % CTRL_EVT_RING_SIZE;
+#ifdef CTRL_EVT_USE_IRQ
+        if (irq_masked) {
+            irq_masked = 0;
+            CTRL_EVT_WR(CTRL_EVT_REG_CTRL, ctrl_reg);
+        }
+#endif
+
+        if (skip_valid) {
+            if (!TS_BEFORE(e.ts, skip_from) && TS_BEFORE(e.ts, skip_to))
+                continue;
+            if (!TS_BEFORE(e.ts, skip_to))
+                skip_valid = 0;
+        }
+
+        if ((e.evt >> CTRL_EVT_SRC_OFFS) == CTRL_EVT_SRC_BTN) {
+            last_word = (last_word & ~CTRL_WORD_BTN_MASK) | (e.evt & CTRL_WORD_BTN_MASK);
+            *controls = last_word;
+            stats.replayed++;
+            return 1;
+        }
+
+        code = e.evt & CTRL_WORD_RC_MASK;
+        cnt = (e.evt & CTRL_WORD_RRPT_MASK) >> CTRL_WORD_RRPT_OFFS;
+
+        if (!ir_held || (code != ir_code) || (cnt == 1) || TS_BEFORE(ir_frame_ts + CTRL_EVT_IR_RELEASE_US, e.ts)) {
+            ir_held = 1;
+            ir_code = code;
+            ir_rpt = 1;
+            ir_press_ts = ir_emit_ts = ir_frame_ts = e.ts;
+
+            // back-to-back presses are separated by an idle word so that count changes
+            if (((last_word & CTRL_WORD_RRPT_MASK) >> CTRL_WORD_RRPT_OFFS) == 1) {
+                pending_word = (last_word & CTRL_WORD_BTN_MASK) | (1 << CTRL_WORD_RRPT_OFFS) | ir_code;
+                pending = 1;
+                last_word &= CTRL_WORD_BTN_MASK;
+                *controls = last_word;
+                return 1;
+            }
+        } else {
+            ir_frame_ts = e.ts;
+            if (TS_BEFORE(e.ts, ir_press_ts + CTRL_EVT_RPT_DELAY_US) || TS_BEFORE(e.ts, ir_emit_ts + CTRL_EVT_RPT_PERIOD_US))
+                continue;
+
+            now = CTRL_EVT_RD(CTRL_EVT_REG_TIME);
+            if (TS_BEFORE(e.ts + CTRL_EVT_RPT_MAX_AGE_US, now)) {
+                stats.rpt_dropped++;
+                continue;
+            }
+            ir_emit_ts = e.ts;
+            ir_rpt = ((ir_rpt < 6) || (ir_rpt == 255)) ? 6 : ir_rpt+1;
+        }
+
+        last_word = (last_word & CTRL_WORD_BTN_MASK) | ((uint32_t)ir_rpt << CTRL_WORD_RRPT_OFFS) | ir_code;
+        *controls = last_word;
+        stats.replayed++;
+        return 1;
+    }
+
+    return 0;
+}
+
+void ctrl_events_replay(uint32_t controls) {
+    last_word = controls;
+    CTRL_EVT_WR(CTRL_EVT_REG_OVR, controls);
+}
+
+uint32_t ctrl_events_last() {
+    return last_word;
+}
+
+const ctrl_events_stats_t* ctrl_events_get_stats() {
+    return &stats;
+}
+
+#endif
@@ -0,0 +1,106 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef CTRL_EVENTS_H_
+#define CTRL_EVENTS_H_
+
+#include <stdint.h>
+#include "system.h"
+
+// Register map of ctrl_event_fifo (ip_extra/ctrl_event_fifo)
+#define CTRL_EVT_REG_CTRL       0
+#define CTRL_EVT_REG_EVT_TS     1
+#define CTRL_EVT_REG_EVT        2
+#define CTRL_EVT_REG_TIME       3
+#define CTRL_EVT_REG_OVR        4
+#define CTRL_EVT_REG_EXP_TS     5
+
+#define CTRL_EVT_LEVEL_MASK     0x3f
+#define CTRL_EVT_OVERFLOW       (1<<8)
+#define CTRL_EVT_OVR_EXPIRED    (1<<9)
+#define CTRL_EVT_IRQ_EN         (1<<16)
+#define CTRL_EVT_OVR_EN         (1<<17)
+
+#define CTRL_EVT_SRC_OFFS       30
+#define CTRL_EVT_SRC_IR         1
+#define CTRL_EVT_SRC_BTN        2
+
+// pio_1 controls word layout
+#define CTRL_WORD_RC_MASK       0x0000ffff
+#define CTRL_WORD_RRPT_OFFS     16
+#define CTRL_WORD_RRPT_MASK     0x00ff0000
+#define CTRL_WORD_BTN_MASK      0x3f000000
+
+// IR auto-repeat timing, evaluated on event timestamps instead of main loop iterations
+#ifndef CTRL_EVT_IR_RELEASE_US
+#define CTRL_EVT_IR_RELEASE_US  150000
+#endif
+#ifndef CTRL_EVT_RPT_DELAY_US
+#define CTRL_EVT_RPT_DELAY_US   400000
+#endif
+#ifndef CTRL_EVT_RPT_PERIOD_US
+#define CTRL_EVT_RPT_PERIOD_US  100000
+#endif
+// repeats older than this when processed are dropped so that a stalled main loop does not
+// replay a burst of them afterwards (presses and button changes are always delivered)
+#ifndef CTRL_EVT_RPT_MAX_AGE_US
+#define CTRL_EVT_RPT_MAX_AGE_US 250000
+#endif
+
+#define CTRL_EVT_RING_SIZE      64
+
+typedef struct {
+    uint32_t ts;
+    uint32_t evt;
+} ctrl_event_t;
+
+typedef struct {
+    uint32_t events;
+    uint32_t replayed;
+    uint32_t rpt_dropped;
+    uint32_t hw_overflows;
+    uint32_t ring_overflows;
+} ctrl_events_stats_t;
+
+#ifdef CTRL_EVENT_FIFO_0_BASE
+
+// Enables event capture and controls override. Interrupt driven on Nios2, polled otherwise.
+void ctrl_events_init();
+
+// Moves pending events from hardware FIFO to software ring. Called from ISR or main loop.
+void ctrl_events_drain();
+
+// Returns 1 and next controls word to replay through pio_1, or 0 when no events are pending.
+// Press/repeat decisions are made from IR frame timestamps. Repeats are reported with
+// increasing count starting from 6 so that they pass read_controls() repeat delay as is.
+int ctrl_events_next(uint32_t *controls);
+
+// Presents controls word to read_controls() and refreshes override timeout
+void ctrl_events_replay(uint32_t controls);
+uint32_t ctrl_events_last();
+
+// Override is disabled around code that polls controls outside main loop (e.g. remote setup)
+void ctrl_events_override(int enable);
+
+const ctrl_events_stats_t* ctrl_events_get_stats();
+
+#endif
+
+#endif /* CTRL_EVENTS_H_ */
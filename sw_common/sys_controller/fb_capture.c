@@ -0,0 +1,116 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include <stdio.h>
+#include <string.h>
+#include "fb_capture.h"
+#include "ff.h"
+#include "diskio.h"
+#include "scratch.h"
+
+#ifdef FB_CAPTURE_DDR_WINDOW
+
+#define FB_CAPTURE_MAX_FILES    1000
+
+extern uint8_t sd_det;
+
+int fb_capture_write(uint16_t width, uint16_t height, uint8_t buffer_idx, uint32_t frame_cnt, char *filename, int filename_len) {
+    scratch_mark_t mark = scratch_mark();
+    FIL *fp = scratch_alloc(sizeof(FIL));
+    uint8_t *hdr_buf = scratch_alloc(FB_CAPTURE_HDR_SIZE);
+    fb_capture_hdr_t *hdr = (fb_capture_hdr_t*)hdr_buf;
+    FATFS *fs;
+    FRESULT res = FR_EXIST;
+    LBA_t sect;
+    UINT bw;
+    uint32_t stride, frame_bytes, src, remaining, chunk;
+    int i, retval = FB_CAPTURE_OK;
+
+    if (!sd_det) {
+        scratch_release(mark);
+        return FB_CAPTURE_NO_SD;
+    }
+    if (!fp || !hdr_buf) {
+        scratch_release(mark);
+        return FB_CAPTURE_FILE_ERROR;
+    }
+
+    stride = ((width + VFB_PIXELS_PER_WORD - 1) / VFB_PIXELS_PER_WORD) * VFB_WORD_BYTES;
+    frame_bytes = stride * height;
+
+    for (i=0; (i<FB_CAPTURE_MAX_FILES) && (res == FR_EXIST); i++) {
+        sniprintf(filename, filename_len, "cap%03d.raw", i);
+        res = f_open(fp, filename, FA_WRITE|FA_CREATE_NEW);
+    }
+    if (res != FR_OK) {
+        scratch_release(mark);
+        return FB_CAPTURE_FILE_ERROR;
+    }
+
+    memset(hdr_buf, 0, FB_CAPTURE_HDR_SIZE);
+    hdr->magic = FB_CAPTURE_MAGIC;
+    hdr->version = FB_CAPTURE_VERSION;
+    hdr->hdr_size = FB_CAPTURE_HDR_SIZE;
+    hdr->width = width;
+    hdr->height = height;
+    hdr->stride = stride;
+    hdr->frame_bytes = frame_bytes;
+    hdr->word_bytes = VFB_WORD_BYTES;
+    hdr->pixels_per_word = VFB_PIXELS_PER_WORD;
+    hdr->pixels_in_parallel = VFB_PIXELS_IN_PARALLEL;
+    hdr->symbols_per_pixel = VFB_SYMBOLS_PER_PIXEL;
+    hdr->bits_per_symbol = VFB_BITS_PER_SYMBOL;
+    hdr->buffer_idx = buffer_idx;
+    hdr->frame_cnt = frame_cnt;
+
+    // Allocate contiguous clusters (also sets file size) so that frame data can bypass FatFs
+    if ((f_expand(fp, FB_CAPTURE_HDR_SIZE+frame_bytes, 1) != FR_OK) ||
+        (f_write(fp, hdr_buf, FB_CAPTURE_HDR_SIZE, &bw) != FR_OK) ||
+        (bw != FB_CAPTURE_HDR_SIZE) ||
+        (f_sync(fp) != FR_OK)) {
+        retval = FB_CAPTURE_FILE_ERROR;
+        goto close;
+    }
+
+    fs = fp->obj.fs;
+    sect = fs->database + (LBA_t)fs->csize*(fp->obj.sclust-2) + FB_CAPTURE_HDR_SIZE/FF_MIN_SS;
+    src = FB_CAPTURE_DDR_WINDOW + VFB_MEM_BASE + buffer_idx*VFB_BUF_OFFSET;
+    remaining = (frame_bytes + FF_MIN_SS - 1) / FF_MIN_SS;
+
+    // Source pointer is a DDR address in SD controller DMA master space, never touched by CPU
+    while (remaining > 0) {
+        chunk = (remaining > fs->csize) ? fs->csize : remaining;
+        if (disk_write(fs->pdrv, (const BYTE*)src, sect, chunk) != RES_OK) {
+            retval = FB_CAPTURE_WRITE_ERROR;
+            break;
+        }
+        src += chunk*FF_MIN_SS;
+        sect += chunk;
+        remaining -= chunk;
+    }
+
+close:
+    f_close(fp);
+    scratch_release(mark);
+
+    return retval;
+}
+
+#endif
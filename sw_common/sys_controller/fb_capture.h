@@ -0,0 +1,77 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef FB_CAPTURE_H_
+#define FB_CAPTURE_H_
+
+#include <stdint.h>
+#include "sysconfig.h"
+
+#define FB_CAPTURE_MAGIC        0x42465844  // "DXFB"
+#define FB_CAPTURE_VERSION      1
+#define FB_CAPTURE_HDR_SIZE     512
+
+// VFB memory packing (alt_vip_cl_vfb_0 parameters): 8-bit symbols, 3 parallel planes (2 with 4:2:2),
+// 2 pixels in parallel and 256-bit memory port. Beats are not split across words and lines start word aligned.
+#define VFB_WORD_BYTES          32
+#define VFB_PIXELS_IN_PARALLEL  2
+#ifdef VIP_422
+#define VFB_SYMBOLS_PER_PIXEL   2
+#else
+#define VFB_SYMBOLS_PER_PIXEL   3
+#endif
+#define VFB_BITS_PER_SYMBOL     8
+#define VFB_NUM_BUFFERS         3
+#define VFB_BEATS_PER_WORD      ((VFB_WORD_BYTES*8)/(VFB_PIXELS_IN_PARALLEL*VFB_SYMBOLS_PER_PIXEL*VFB_BITS_PER_SYMBOL))
+#define VFB_PIXELS_PER_WORD     (VFB_BEATS_PER_WORD*VFB_PIXELS_IN_PARALLEL)
+
+// Raw capture file header, zero-padded to FB_CAPTURE_HDR_SIZE. Frame data follows as-is
+// from DDR (line by line, stride bytes each) and is converted to BMP/PNG on host side.
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t hdr_size;
+    uint16_t width;
+    uint16_t height;
+    uint32_t stride;
+    uint32_t frame_bytes;
+    uint8_t word_bytes;
+    uint8_t pixels_per_word;
+    uint8_t pixels_in_parallel;
+    uint8_t symbols_per_pixel;
+    uint8_t bits_per_symbol;
+    uint8_t buffer_idx;
+    uint16_t reserved;
+    uint32_t frame_cnt;
+} fb_capture_hdr_t;
+
+typedef enum {
+    FB_CAPTURE_OK           = 0,
+    FB_CAPTURE_NOT_AVAIL    = -1,
+    FB_CAPTURE_NO_SD        = -2,
+    FB_CAPTURE_FILE_ERROR   = -3,
+    FB_CAPTURE_WRITE_ERROR  = -4,
+} fb_capture_status_t;
+
+// Stream given VFB buffer to a new capNNN.raw file on SD. VFB writes must be halted by caller.
+// Pixel data is moved by SD controller DMA directly from DDR, one cluster per transfer.
+int fb_capture_write(uint16_t width, uint16_t height, uint8_t buffer_idx, uint32_t frame_cnt, char *filename, int filename_len);
+
+#endif /* FB_CAPTURE_H_ */
@@ -0,0 +1,59 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include "frame_mult.h"
+#include "int_scale.h"
+
+uint8_t frame_mult_enable = FRAME_MULT_DEFAULT;
+uint8_t frame_mult_active;
+
+oper_mode_t frame_mult_select(oper_mode_t oper_mode, mode_data_t *vm_in, mode_data_t *vm_out, vm_proc_config_t *vm_conf) {
+    uint32_t in_hz = vm_in->timings.v_hz_x100;
+    uint32_t out_hz = vm_out->timings.v_hz_x100;
+    uint32_t mult, vdiff;
+
+    frame_mult_active = 0;
+
+    if (!frame_mult_enable || (FRAME_MULT_MAX < 2) || (oper_mode != OPERMODE_ADAPT_LM) || !in_hz || !vm_in->timings.v_total)
+        return oper_mode;
+
+    // frames are repeated from EMIF linebuffer as-is, so line repetition must not drop input lines
+    if (vm_in->timings.interlaced || vm_out->timings.interlaced || (vm_conf->y_rpt < 0))
+        return oper_mode;
+
+    mult = (out_hz + in_hz/2) / in_hz;
+    if ((mult < 2) || (mult > FRAME_MULT_MAX))
+        return oper_mode;
+
+    vdiff = (out_hz > mult*in_hz) ? out_hz-mult*in_hz : mult*in_hz-out_hz;
+    if (vdiff*1000 > INT_SCALE_MAX_VDIFF_X1000*mult*in_hz)
+        return oper_mode;
+
+    vm_conf->framelock = mult;
+    vm_conf->si_pclk_mult = 0;
+    vm_conf->framesync_line = lm_framesync_line(vm_in, vm_out, vm_conf, mult);
+    frame_mult_active = mult;
+
+    return oper_mode;
+}
+
+uint8_t frame_mult_bfi_lit_frames(avconfig_t *avconfig) {
+    return (frame_mult_active && avconfig->bfi_enable) ? FRAME_MULT_BFI_LIT : 0;
+}
@@ -0,0 +1,52 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef FRAME_MULT_H_
+#define FRAME_MULT_H_
+
+#include <stdint.h>
+#include "sysconfig.h"
+#include "avconfig.h"
+#include "video_modes.h"
+
+// Boards without EMIF frame buffer cannot repeat frames in LM path
+#ifndef FRAME_MULT_MAX
+#define FRAME_MULT_MAX      1
+#endif
+
+#ifndef FRAME_MULT_DEFAULT
+#define FRAME_MULT_DEFAULT  1
+#endif
+
+// Shown frames per input frame when BFI is enabled in frame multiplication mode
+#define FRAME_MULT_BFI_LIT  1
+
+extern uint8_t frame_mult_enable;
+extern uint8_t frame_mult_active;
+
+// Locks an adaptive LM mode whose output refresh is 2x-FRAME_MULT_MAX times input refresh to input SOF,
+// scanning out the first output frame of each input frame with minimum framesync lag. Sets vm_conf->framelock
+// to the multiplier and frame_mult_active accordingly (0 if not applicable). Returns oper_mode as-is.
+oper_mode_t frame_mult_select(oper_mode_t oper_mode, mode_data_t *vm_in, mode_data_t *vm_out, vm_proc_config_t *vm_conf);
+
+// Value for bfi_sched lit_frames control (0 = BFI off)
+uint8_t frame_mult_bfi_lit_frames(avconfig_t *avconfig);
+
+#endif /* FRAME_MULT_H_ */
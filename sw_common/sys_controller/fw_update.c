@@ -0,0 +1,344 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include <string.h>
+#include <stddef.h>
+#include "sysconfig.h"
+#include "fw_update.h"
+#include "crc32.h"
+#include "hal.h"
+#include "flash.h"
+#include "ff.h"
+#include "scratch.h"
+
+#ifdef FW_UPDATE_BOARD_ID
+
+// Intel Generic Serial Flash Interface CSR word offsets
+#define GSFI_REG_CTRL           0
+#define GSFI_REG_CMD_CFG        7
+#define GSFI_REG_CMD_CTRL       8
+#define GSFI_REG_CMD_ADDR       9
+#define GSFI_REG_CMD_WRDATA0    10
+#define GSFI_REG_CMD_RDDATA0    12
+
+#define GSFI_CTRL_4BYTE_ADDR    (1<<8)
+#define GSFI_CMD_START          (1<<0)
+#define GSFI_CMD_CFG(opcode, addr_bytes, data_bytes)    ((opcode) | ((addr_bytes)<<8) | ((data_bytes)<<12))
+
+#define FLASH_OP_WREN           0x06
+#define FLASH_OP_RDSR           0x05
+#define FLASH_SR_WIP            (1<<0)
+
+#define FW_UPDATE_CSR_BASE      INTEL_GENERIC_SERIAL_FLASH_INTERFACE_TOP_0_AVL_CSR_BASE
+#define FW_UPDATE_MEM_BASE      INTEL_GENERIC_SERIAL_FLASH_INTERFACE_TOP_0_AVL_MEM_BASE
+
+#define FW_UPDATE_ERASE_TIMEOUT_US  3000000
+#define FW_UPDATE_PROG_TIMEOUT_US   5000
+#define FW_UPDATE_POS_NONE      0xffffffff
+
+#if (FW_UPDATE_ERASE_SIZE % FW_UPDATE_CHUNK_SIZE) || (FW_UPDATE_CHUNK_SIZE % FW_UPDATE_PAGE_SIZE)
+#error Erase unit must be a multiple of chunk size which must be a multiple of page size
+#endif
+
+typedef enum {
+    UNIT_UNCHANGED = 0,
+    UNIT_PROGRAM   = 1,
+    UNIT_ERASE     = 2,
+} unit_state_t;
+
+// Double buffer and file object are taken from scratch arena for the duration of fw_update_run()
+static uint8_t (*fw_update_buf)[FW_UPDATE_CHUNK_SIZE];
+static FIL *fw_update_file;
+static uint32_t fw_update_buf_pos[2];
+static uint32_t fw_update_image_size;
+static uint8_t flash_addr_bytes;
+
+extern uint8_t sd_det;
+extern flash_ctrl_dev flashctrl_dev;
+
+static void flash_cmd(uint32_t cfg, uint32_t addr) {
+    IOWR(FW_UPDATE_CSR_BASE, GSFI_REG_CMD_CFG, cfg);
+    IOWR(FW_UPDATE_CSR_BASE, GSFI_REG_CMD_ADDR, addr);
+    IOWR(FW_UPDATE_CSR_BASE, GSFI_REG_CMD_CTRL, GSFI_CMD_START);
+}
+
+static int flash_wait_idle(uint32_t timeout_us) {
+    hal_timestamp_t start_ts = hal_timestamp();
+
+    do {
+        flash_cmd(GSFI_CMD_CFG(FLASH_OP_RDSR, 0, 1), 0);
+        if (!(IORD(FW_UPDATE_CSR_BASE, GSFI_REG_CMD_RDDATA0) & FLASH_SR_WIP))
+            return 0;
+    } while (hal_timestamp() < start_ts + hal_us_to_ticks(timeout_us));
+
+    return -1;
+}
+
+// Returns immediately, flash stays busy until erase completes
+static void flash_erase_start(uint32_t addr) {
+    flash_cmd(GSFI_CMD_CFG(FLASH_OP_WREN, 0, 0), 0);
+    flash_cmd(GSFI_CMD_CFG(FW_UPDATE_ERASE_OPCODE, flash_addr_bytes, 0), addr);
+}
+
+// Each single-word write on memory interface is a separate page program command which
+// clears write enable latch, so WREN must be issued for every word. Returns with the last
+// word still being programmed; flash_wait_idle() must be called before reading back.
+static int flash_program_page(uint32_t addr, const uint8_t *src, uint32_t len) {
+    uint32_t i;
+
+    for (i=0; i<len; i+=4) {
+        if (flash_wait_idle(FW_UPDATE_PROG_TIMEOUT_US) != 0)
+            return -1;
+        flash_cmd(GSFI_CMD_CFG(FLASH_OP_WREN, 0, 0), 0);
+        IOWR_32DIRECT(FW_UPDATE_MEM_BASE, addr+i, *(const uint32_t*)(src+i));
+    }
+
+    return 0;
+}
+
+static unit_state_t flash_diff(uint32_t addr, const uint8_t *src, uint32_t len) {
+    unit_state_t state = UNIT_UNCHANGED;
+    uint32_t i, f, d;
+
+    for (i=0; i<len; i+=4) {
+        f = IORD_32DIRECT(FW_UPDATE_MEM_BASE, addr+i);
+        d = *(const uint32_t*)(src+i);
+        if (f != d) {
+            // programming can only clear bits
+            if (d & ~f)
+                return UNIT_ERASE;
+            state = UNIT_PROGRAM;
+        }
+    }
+
+    return state;
+}
+
+static uint32_t flash_crc(uint32_t crc, uint32_t addr, uint32_t len) {
+    uint32_t i, w;
+
+    for (i=0; i<len; i+=4) {
+        w = IORD_32DIRECT(FW_UPDATE_MEM_BASE, addr+i);
+        crc = crc32_update(crc, (const uint8_t*)&w, 4);
+    }
+
+    return crc;
+}
+
+static uint32_t chunk_len(uint32_t pos) {
+    return ((fw_update_image_size - pos) < FW_UPDATE_CHUNK_SIZE) ? (fw_update_image_size - pos) : FW_UPDATE_CHUNK_SIZE;
+}
+
+// Load image data at pos into buffer idx unless it is already there
+static int fw_update_load(int idx, uint32_t pos) {
+    UINT br;
+    uint32_t len = chunk_len(pos);
+
+    if (fw_update_buf_pos[idx] == pos)
+        return 0;
+
+    fw_update_buf_pos[idx] = FW_UPDATE_POS_NONE;
+    if ((f_tell(fw_update_file) != FW_UPDATE_HDR_SIZE+pos) && (f_lseek(fw_update_file, FW_UPDATE_HDR_SIZE+pos) != FR_OK))
+        return -1;
+    if ((f_read(fw_update_file, fw_update_buf[idx], len, &br) != FR_OK) || (br != len))
+        return -1;
+
+    fw_update_buf_pos[idx] = pos;
+    return 0;
+}
+
+static int fw_update_check_hdr(fw_update_hdr_t *hdr) {
+    uint32_t crc = crc32_update(CRC32_INIT, (const uint8_t*)hdr, offsetof(fw_update_hdr_t, hdr_crc)) ^ 0xffffffff;
+
+    return ((hdr->magic == FW_UPDATE_MAGIC) &&
+            (hdr->version == FW_UPDATE_VERSION) &&
+            (hdr->hdr_size == FW_UPDATE_HDR_SIZE) &&
+            (hdr->hdr_crc == crc) &&
+            (hdr->board_id == FW_UPDATE_BOARD_ID) &&
+            (hdr->image_size > 0) &&
+            ((hdr->image_size % FW_UPDATE_PAGE_SIZE) == 0) &&
+            ((hdr->flash_offset % FW_UPDATE_ERASE_SIZE) == 0) &&
+            (hdr->flash_offset + hdr->image_size <= flashctrl_dev.flash_size) &&
+            (f_size(fw_update_file) == FW_UPDATE_HDR_SIZE + hdr->image_size)) ? 0 : -1;
+}
+
+int fw_update_run(fw_update_progress_cb progress_cb, fw_update_stats_t *stats) {
+    fw_update_hdr_t hdr;
+    UINT br;
+    uint32_t crc, crc_src, pos, unit_pos, unit_len, off, len, p, flash_addr;
+    unit_state_t state, chunk_state;
+    int cur, erase_pending, retry, retval = FW_UPDATE_OK;
+    scratch_mark_t mark;
+
+    memset(stats, 0, sizeof(fw_update_stats_t));
+
+    if (!sd_det)
+        return FW_UPDATE_NO_SD;
+
+    mark = scratch_mark();
+    fw_update_file = scratch_alloc(sizeof(FIL));
+    fw_update_buf = scratch_alloc(2*FW_UPDATE_CHUNK_SIZE);
+
+    if (!fw_update_file || !fw_update_buf || (f_open(fw_update_file, FW_UPDATE_FILENAME, FA_READ) != FR_OK)) {
+        scratch_release(mark);
+        return FW_UPDATE_FILE_ERROR;
+    }
+
+    if ((f_read(fw_update_file, fw_update_buf[0], FW_UPDATE_HDR_SIZE, &br) != FR_OK) || (br != FW_UPDATE_HDR_SIZE)) {
+        retval = FW_UPDATE_FILE_ERROR;
+        goto close;
+    }
+    memcpy(&hdr, fw_update_buf[0], sizeof(fw_update_hdr_t));
+    if (fw_update_check_hdr(&hdr) != 0) {
+        retval = FW_UPDATE_HDR_ERROR;
+        goto close;
+    }
+    fw_update_image_size = hdr.image_size;
+    fw_update_buf_pos[0] = fw_update_buf_pos[1] = FW_UPDATE_POS_NONE;
+
+    // Verify whole image before flash is touched so that a corrupted file cannot leave a half-written flash
+    crc = CRC32_INIT;
+    for (pos=0; pos<hdr.image_size; pos+=FW_UPDATE_CHUNK_SIZE) {
+        if (fw_update_load(0, pos) != 0) {
+            retval = FW_UPDATE_FILE_ERROR;
+            goto close;
+        }
+        crc = crc32_update(crc, fw_update_buf[0], chunk_len(pos));
+    }
+    if ((crc ^ 0xffffffff) != hdr.image_crc) {
+        retval = FW_UPDATE_IMAGE_CRC;
+        goto close;
+    }
+
+    flash_addr_bytes = (IORD(FW_UPDATE_CSR_BASE, GSFI_REG_CTRL) & GSFI_CTRL_4BYTE_ADDR) ? 4 : 3;
+    stats->units_total = (hdr.image_size + FW_UPDATE_ERASE_SIZE - 1) / FW_UPDATE_ERASE_SIZE;
+
+    // Running CRC over flash readback. Each page is checked by chaining both source and readback
+    // data from it, so at the end it also covers the whole programmed image.
+    crc = CRC32_INIT;
+    cur = 0;
+
+    for (unit_pos=0; unit_pos<hdr.image_size; unit_pos+=FW_UPDATE_ERASE_SIZE) {
+        unit_len = ((hdr.image_size - unit_pos) < FW_UPDATE_ERASE_SIZE) ? (hdr.image_size - unit_pos) : FW_UPDATE_ERASE_SIZE;
+        flash_addr = hdr.flash_offset + unit_pos;
+
+        // Classify erase unit against current flash content (first chunk was usually prefetched)
+        state = UNIT_UNCHANGED;
+        for (off=0; (off<unit_len) && (state != UNIT_ERASE); off+=FW_UPDATE_CHUNK_SIZE) {
+            if (fw_update_buf_pos[cur^1] == unit_pos+off)
+                cur ^= 1;
+            if (fw_update_load(cur, unit_pos+off) != 0) {
+                retval = FW_UPDATE_FILE_ERROR;
+                goto close;
+            }
+            chunk_state = flash_diff(flash_addr+off, fw_update_buf[cur], chunk_len(unit_pos+off));
+            if (chunk_state > state)
+                state = chunk_state;
+        }
+
+        if (state == UNIT_UNCHANGED) {
+            crc = flash_crc(crc, flash_addr, unit_len);
+            stats->units_unchanged++;
+        } else {
+            erase_pending = (state == UNIT_ERASE);
+            if (erase_pending) {
+                flash_erase_start(flash_addr);
+                stats->units_erased++;
+            }
+
+            for (off=0; off<unit_len; off+=FW_UPDATE_CHUNK_SIZE) {
+                pos = unit_pos+off;
+                len = chunk_len(pos);
+
+                if (fw_update_buf_pos[cur^1] == pos)
+                    cur ^= 1;
+                if (fw_update_load(cur, pos) != 0) {
+                    retval = FW_UPDATE_FILE_ERROR;
+                    goto close;
+                }
+
+                // Read ahead next chunk from SD while flash is busy erasing
+                if (erase_pending) {
+                    if ((pos+len < hdr.image_size) && (fw_update_load(cur^1, pos+len) != 0)) {
+                        retval = FW_UPDATE_FILE_ERROR;
+                        goto close;
+                    }
+                    if (flash_wait_idle(FW_UPDATE_ERASE_TIMEOUT_US) != 0) {
+                        retval = FW_UPDATE_FLASH_ERROR;
+                        goto close;
+                    }
+                    erase_pending = 0;
+                }
+
+                for (p=0; p<len; p+=FW_UPDATE_PAGE_SIZE) {
+                    if ((flash_diff(flash_addr+off+p, fw_update_buf[cur]+p, FW_UPDATE_PAGE_SIZE) != UNIT_UNCHANGED) &&
+                        (flash_program_page(flash_addr+off+p, fw_update_buf[cur]+p, FW_UPDATE_PAGE_SIZE) != 0)) {
+                        retval = FW_UPDATE_FLASH_ERROR;
+                        goto close;
+                    }
+                }
+
+                // ...and while the last word of the chunk is being programmed
+                if ((pos+len < hdr.image_size) && (fw_update_load(cur^1, pos+len) != 0)) {
+                    retval = FW_UPDATE_FILE_ERROR;
+                    goto close;
+                }
+                if (flash_wait_idle(FW_UPDATE_PROG_TIMEOUT_US) != 0) {
+                    retval = FW_UPDATE_FLASH_ERROR;
+                    goto close;
+                }
+
+                for (p=0; p<len; p+=FW_UPDATE_PAGE_SIZE) {
+                    crc_src = crc32_update(crc, fw_update_buf[cur]+p, FW_UPDATE_PAGE_SIZE);
+                    for (retry=0; ; retry++) {
+                        if (flash_crc(crc, flash_addr+off+p, FW_UPDATE_PAGE_SIZE) == crc_src)
+                            break;
+                        if (retry > 0) {
+                            retval = FW_UPDATE_VERIFY_ERROR;
+                            goto close;
+                        }
+                        if ((flash_program_page(flash_addr+off+p, fw_update_buf[cur]+p, FW_UPDATE_PAGE_SIZE) != 0) ||
+                            (flash_wait_idle(FW_UPDATE_PROG_TIMEOUT_US) != 0)) {
+                            retval = FW_UPDATE_FLASH_ERROR;
+                            goto close;
+                        }
+                        stats->pages_retried++;
+                    }
+                    crc = crc_src;
+                }
+            }
+            stats->units_programmed++;
+        }
+
+        if (progress_cb)
+            progress_cb(unit_pos+unit_len, hdr.image_size);
+    }
+
+    if ((crc ^ 0xffffffff) != hdr.image_crc)
+        retval = FW_UPDATE_VERIFY_ERROR;
+
+close:
+    f_close(fw_update_file);
+    scratch_release(mark);
+
+    return retval;
+}
+
+#endif
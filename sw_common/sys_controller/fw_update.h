@@ -0,0 +1,81 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef FW_UPDATE_H_
+#define FW_UPDATE_H_
+
+#include <stdint.h>
+
+#define FW_UPDATE_MAGIC         0x55465844  // "DXFU"
+#define FW_UPDATE_VERSION       1
+#define FW_UPDATE_HDR_SIZE      512
+#define FW_UPDATE_FILENAME      "fw_update.bin"
+
+// Board IDs stored in image header
+#define FW_UPDATE_BOARD_C5G     1
+#define FW_UPDATE_BOARD_DE2_115 2
+
+// SD read / flash program unit. Two of these are used as double buffer.
+#ifndef FW_UPDATE_CHUNK_SIZE
+#define FW_UPDATE_CHUNK_SIZE    4096
+#endif
+#define FW_UPDATE_PAGE_SIZE     256
+
+// Image header at the beginning of update file, zero-padded to FW_UPDATE_HDR_SIZE. Raw flash
+// image (.rpd generated from .cof, little endian) follows and is written from flash_offset on.
+// Image size is a multiple of FW_UPDATE_PAGE_SIZE (see sw_common/fw_image).
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t hdr_size;
+    uint32_t board_id;
+    uint32_t flash_offset;
+    uint32_t image_size;
+    uint32_t image_crc;
+    uint32_t hdr_crc;       // over preceding fields
+} fw_update_hdr_t;
+
+typedef enum {
+    FW_UPDATE_OK            = 0,
+    FW_UPDATE_NO_SD         = -1,
+    FW_UPDATE_FILE_ERROR    = -2,
+    FW_UPDATE_HDR_ERROR     = -3,
+    FW_UPDATE_IMAGE_CRC     = -4,
+    FW_UPDATE_FLASH_ERROR   = -5,
+    FW_UPDATE_VERIFY_ERROR  = -6,
+} fw_update_status_t;
+
+typedef struct {
+    uint32_t units_total;
+    uint32_t units_erased;
+    uint32_t units_programmed;
+    uint32_t units_unchanged;
+    uint32_t pages_retried;
+} fw_update_stats_t;
+
+// Called after each erase unit with bytes processed so far
+typedef void (*fw_update_progress_cb)(uint32_t done, uint32_t total);
+
+// Stream FW_UPDATE_FILENAME from SD into serial flash. Image CRC is checked before flash is touched,
+// only erase units whose content differs are erased (or just programmed if no bit needs to go 0->1),
+// and each page is read back and checked right after it has been programmed.
+int fw_update_run(fw_update_progress_cb progress_cb, fw_update_stats_t *stats);
+
+#endif /* FW_UPDATE_H_ */
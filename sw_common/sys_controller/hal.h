@@ -0,0 +1,128 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef HAL_H_
+#define HAL_H_
+
+#include <stdint.h>
+#include "system.h"
+
+// Backend selection. Nios2 is the default; HAL_HPS targets bare-metal Cortex-A9 on DE10-Nano
+// accessing the FPGA peripherals via the lightweight HPS-to-FPGA bridge, and HAL_HOST builds
+// the controller as a Linux process with a memory-backed register file for testing.
+#if defined(HAL_HPS) && defined(HAL_HOST)
+#error Only one HAL backend can be selected
+#endif
+
+// I2C masters are clocked from the FPGA system clock regardless of which CPU drives them
+#define HAL_I2C_REF_FREQ        ALT_CPU_FREQ
+
+#if defined(HAL_HPS)
+
+// Lightweight HPS-to-FPGA bridge reaches the peripherals through hps_lw_bridge_0 in sys.qsys, which
+// maps each of them at its Nios2 data master address modulo the 2MB window (VIP cores behind the
+// clock crossing bridge at 0x01000000 thus land at window offset 0)
+#define HAL_LWH2F_BASE          0xFF200000
+#define HAL_LWH2F_SPAN          0x200000
+#define HAL_A9_GTIMER_BASE      0xFFFEC200
+#ifndef HAL_TIMESTAMP_FREQ
+#define HAL_TIMESTAMP_FREQ      25000000    // PERIPHCLK = MPU clock (100MHz via u-boot.script) / 4
+#endif
+
+#define HAL_MMIO_ADDR(base)     (HAL_LWH2F_BASE + ((uint32_t)(base) & (HAL_LWH2F_SPAN-1)))
+
+#elif defined(HAL_HOST)
+
+#define HAL_HOST_MMIO_SPAN      0x100000
+#define HAL_TIMESTAMP_FREQ      1000000
+
+extern uint32_t hal_host_mmio[HAL_HOST_MMIO_SPAN/4];
+
+#define HAL_MMIO_ADDR(base)     ((uintptr_t)hal_host_mmio + ((uint32_t)(base) & (HAL_HOST_MMIO_SPAN-1)))
+
+#else // Nios2
+
+#include <unistd.h>
+#include "altera_avalon_pio_regs.h"
+#include "altera_avalon_timer.h"
+#include <sys/alt_timestamp.h>
+
+#define HAL_TIMESTAMP_FREQ      TIMER_0_FREQ
+
+#define HAL_MMIO_ADDR(base)     (base)
+
+#endif
+
+#define HAL_MMIO_PTR(type, base)    ((volatile type*)HAL_MMIO_ADDR(base))
+
+#if defined(HAL_HPS) || defined(HAL_HOST)
+
+// Register access macros compatible with the Nios2 HAL so that the shared IC drivers
+// (i2c_opencores, ocsdc, flash) build unmodified on other backends
+#define IORD(base, reg)             (*(HAL_MMIO_PTR(uint32_t, (base)) + (reg)))
+#define IOWR(base, reg, data)       (*(HAL_MMIO_PTR(uint32_t, (base)) + (reg)) = (data))
+#define IORD_32DIRECT(base, offs)   (*HAL_MMIO_PTR(uint32_t, (base) + (offs)))
+#define IOWR_32DIRECT(base, offs, data) (*HAL_MMIO_PTR(uint32_t, (base) + (offs)) = (data))
+#define IORD_8DIRECT(base, offs)    (*HAL_MMIO_PTR(uint8_t, (base) + (offs)))
+#define IOWR_8DIRECT(base, offs, data) (*HAL_MMIO_PTR(uint8_t, (base) + (offs)) = (data))
+
+typedef uint64_t hal_timestamp_t;
+
+int hal_init();
+hal_timestamp_t hal_timestamp();
+void hal_usleep(uint32_t us);
+
+#define hal_pio_rd(base)            IORD((base), 0)
+#define hal_pio_wr(base, data)      IOWR((base), 0, (data))
+
+#else
+
+typedef alt_timestamp_type hal_timestamp_t;
+
+#define hal_init()                  alt_timestamp_start()
+#define hal_timestamp()             alt_timestamp()
+#define hal_usleep(us)              usleep(us)
+
+#define hal_pio_rd(base)            IORD_ALTERA_AVALON_PIO_DATA(base)
+#define hal_pio_wr(base, data)      IOWR_ALTERA_AVALON_PIO_DATA((base), (data))
+
+#endif
+
+#define hal_us_to_ticks(us)         ((hal_timestamp_t)(us)*(HAL_TIMESTAMP_FREQ/1000000))
+
+#define hal_i2c_init(base, speed)   I2C_init((base), HAL_I2C_REF_FREQ, (speed))
+
+// I2C transfer shims. IC drivers reach these through hal_i2c.h, which is force-included into
+// every application source and maps I2C_start/I2C_read/I2C_write onto them (see i2c_stats.c).
+int hal_i2c_start(uint32_t base, uint32_t add, uint32_t read);
+uint32_t hal_i2c_read(uint32_t base, uint32_t last);
+uint32_t hal_i2c_write(uint32_t base, uint8_t data, uint32_t last);
+
+// Console goes through stdio: JTAG UART on Nios2, UART0 on HPS (see _write() in hal_hps.c)
+// and stdout on host. Non-Nios2 backends link hal_hps.c or hal_host.c respectively.
+
+// JTAG UART registers, accessed directly by trace output and host command input
+#define JUART_DATA              0
+#define JUART_DATA_RVALID       (1<<15)
+#define JUART_CONTROL           1
+#define JUART_CONTROL_AC        (1<<10)
+#define JUART_CONTROL_WSPACE_OFFS 16
+
+#endif /* HAL_H_ */
@@ -0,0 +1,49 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+// Linux host backend for testing controller logic without hardware. FPGA registers are
+// backed by plain memory which test harnesses can inspect and preload via hal_host_mmio.
+
+#ifdef HAL_HOST
+
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include "hal.h"
+
+uint32_t hal_host_mmio[HAL_HOST_MMIO_SPAN/4];
+
+int hal_init() {
+    return 0;
+}
+
+hal_timestamp_t hal_timestamp() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (hal_timestamp_t)ts.tv_sec*1000000 + ts.tv_nsec/1000;
+}
+
+void hal_usleep(uint32_t us) {
+    usleep(us);
+}
+
+#endif
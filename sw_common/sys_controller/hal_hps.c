@@ -0,0 +1,94 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+// Bare-metal Cortex-A9 backend. Built with HAL_HPS defined; preloader is expected to have
+// configured clocks, SDRAM and UART0 pinmux.
+
+#ifdef HAL_HPS
+
+#include <stdint.h>
+#include <unistd.h>
+#include "hal.h"
+
+#define RSTMGR_BRGMODRST        0xFFD0501C
+#define RSTMGR_BRGMODRST_LWH2F  (1<<1)
+#define L3REGS_REMAP            0xFF800000
+#define L3REGS_REMAP_MPUZERO    (1<<0)
+#define L3REGS_REMAP_H2F        (1<<3)
+#define L3REGS_REMAP_LWH2F      (1<<4)
+
+#define GTIMER_CNT_LO           0x00
+#define GTIMER_CNT_HI           0x04
+#define GTIMER_CTRL             0x08
+
+#define UART0_BASE              0xFFC02000
+#define UART_RBR_THR            0x00
+#define UART_LSR                0x14
+#define UART_LSR_THRE           (1<<5)
+
+#define HPS_REG(addr)           (*(volatile uint32_t*)(addr))
+
+int hal_init() {
+    // release lightweight bridge from reset and make it visible in L3 address map. Remap register is
+    // write-only, so keep on-chip RAM at 0x0 and HPS-to-FPGA bridge visible as set up by preloader.
+    HPS_REG(RSTMGR_BRGMODRST) &= ~RSTMGR_BRGMODRST_LWH2F;
+    HPS_REG(L3REGS_REMAP) = L3REGS_REMAP_MPUZERO | L3REGS_REMAP_H2F | L3REGS_REMAP_LWH2F;
+
+    HPS_REG(HAL_A9_GTIMER_BASE+GTIMER_CTRL) |= 1;
+
+    return 0;
+}
+
+hal_timestamp_t hal_timestamp() {
+    uint32_t hi, lo;
+
+    // re-read upper word in case of carry between accesses
+    do {
+        hi = HPS_REG(HAL_A9_GTIMER_BASE+GTIMER_CNT_HI);
+        lo = HPS_REG(HAL_A9_GTIMER_BASE+GTIMER_CNT_LO);
+    } while (hi != HPS_REG(HAL_A9_GTIMER_BASE+GTIMER_CNT_HI));
+
+    return ((hal_timestamp_t)hi << 32) | lo;
+}
+
+void hal_usleep(uint32_t us) {
+    hal_timestamp_t end = hal_timestamp() + hal_us_to_ticks(us);
+
+    while (hal_timestamp() < end) {}
+}
+
+int usleep(useconds_t us) {
+    hal_usleep(us);
+    return 0;
+}
+
+// newlib retarget for console output
+int _write(int fd, const char *buf, int len) {
+    int i;
+
+    for (i=0; i<len; i++) {
+        while (!(HPS_REG(UART0_BASE+UART_LSR) & UART_LSR_THRE)) {}
+        HPS_REG(UART0_BASE+UART_RBR_THR) = buf[i];
+    }
+
+    return len;
+}
+
+#endif
@@ -0,0 +1,35 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef HAL_I2C_H_
+#define HAL_I2C_H_
+
+// Force-included into all application sources (APP_CFLAGS_USER_FLAGS in Makefile) so that
+// the IC drivers go through the counting HAL shims without modification. i2c_opencores
+// itself is built in BSP and keeps the real entry points. The driver header is pulled in
+// first so that its prototypes are not affected by the macros below.
+#include "i2c_opencores.h"
+#include "hal.h"
+
+#define I2C_start(base, add, read)      hal_i2c_start((base), (add), (read))
+#define I2C_read(base, last)            hal_i2c_read((base), (last))
+#define I2C_write(base, data, last)     hal_i2c_write((base), (data), (last))
+
+#endif /* HAL_I2C_H_ */
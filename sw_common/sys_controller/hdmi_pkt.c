@@ -0,0 +1,62 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include <string.h>
+#include "hdmi_pkt.h"
+
+uint8_t hdmi_if_checksum(const hdmi_infoframe_t *f) {
+    uint8_t sum = 0;
+    int i, len = (f->hb[2] < HDMI_IF_PB_LEN) ? f->hb[2] : HDMI_IF_PB_LEN-1;
+
+    for (i=0; i<HDMI_IF_HB_LEN; i++)
+        sum += f->hb[i];
+    for (i=1; i<=len; i++)
+        sum += f->pb[i];
+
+    return (uint8_t)(0x100 - sum);
+}
+
+int hdmi_if_checksum_ok(const hdmi_infoframe_t *f) {
+    return (f->pb[0] == hdmi_if_checksum(f));
+}
+
+void hdmi_pkt_hf_vsif(hdmi_infoframe_t *f, uint8_t allm) {
+    memset(f, 0, sizeof(hdmi_infoframe_t));
+
+    f->hb[0] = HDMI_IF_TYPE_VENDOR;
+    f->hb[1] = HDMI_HF_VSIF_VERSION;
+    f->hb[2] = HDMI_HF_VSIF_LEN;
+
+    // OUI is sent LSB first
+    f->pb[1] = HDMI_HF_OUI & 0xff;
+    f->pb[2] = (HDMI_HF_OUI >> 8) & 0xff;
+    f->pb[3] = (HDMI_HF_OUI >> 16) & 0xff;
+    f->pb[4] = HDMI_HF_VSIF_VERSION;
+    f->pb[5] = allm ? HDMI_HF_VSIF_PB5_ALLM : 0;
+
+    f->pb[0] = hdmi_if_checksum(f);
+}
+
+void hdmi_pkt_avi_set_content_type(hdmi_infoframe_t *f, uint8_t itc, hdmi_content_type_t cn) {
+    f->pb[3] = itc ? (f->pb[3] | HDMI_AVI_PB3_ITC) : (f->pb[3] & ~HDMI_AVI_PB3_ITC);
+    f->pb[5] = (f->pb[5] & ~HDMI_AVI_PB5_CN_MASK) | ((cn << HDMI_AVI_PB5_CN_OFFS) & HDMI_AVI_PB5_CN_MASK);
+
+    f->pb[0] = hdmi_if_checksum(f);
+}
@@ -0,0 +1,74 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef HDMI_PKT_H_
+#define HDMI_PKT_H_
+
+#include <stdint.h>
+
+// InfoFrame layout as stored in TX packet memory: 3 header bytes, PB0 (checksum) and up to 27 data bytes
+#define HDMI_IF_HB_LEN          3
+#define HDMI_IF_PB_LEN          28
+
+#define HDMI_IF_TYPE_VENDOR     0x81
+#define HDMI_IF_TYPE_AVI        0x82
+
+// HDMI Forum Vendor Specific InfoFrame (HF-VSIF), IEEE OUI 0xC45DD8
+#define HDMI_HF_VSIF_VERSION    0x01
+#define HDMI_HF_VSIF_LEN        5
+#define HDMI_HF_OUI             0xC45DD8
+#define HDMI_HF_VSIF_PB5_ALLM   (1<<1)
+
+// AVI InfoFrame IT content flag (PB3) and content type (PB5), CEA-861-F
+#define HDMI_AVI_VERSION        0x02
+#define HDMI_AVI_LEN            13
+#define HDMI_AVI_PB3_ITC        (1<<7)
+#define HDMI_AVI_PB5_CN_OFFS    4
+#define HDMI_AVI_PB5_CN_MASK    (0x3<<HDMI_AVI_PB5_CN_OFFS)
+
+typedef enum {
+    HDMI_CN_GRAPHICS    = 0,
+    HDMI_CN_PHOTO       = 1,
+    HDMI_CN_CINEMA      = 2,
+    HDMI_CN_GAME        = 3,
+} hdmi_content_type_t;
+
+// Game mode signalling flags (hdmi_game_mode)
+#define HDMI_GAME_ALLM          (1<<0)      // HF-VSIF with ALLM_Mode set
+#define HDMI_GAME_CN            (1<<1)      // AVI ITC=1, CN=Game
+
+typedef struct {
+    uint8_t hb[HDMI_IF_HB_LEN];
+    uint8_t pb[HDMI_IF_PB_LEN];
+} hdmi_infoframe_t;
+
+// Value for PB0 such that header and PB0..PB[length] sum to zero modulo 256
+uint8_t hdmi_if_checksum(const hdmi_infoframe_t *f);
+
+// Returns 1 if PB0 matches header and payload
+int hdmi_if_checksum_ok(const hdmi_infoframe_t *f);
+
+// HF-VSIF carrying only ALLM_Mode (3D and other HDMI 2.x fields cleared)
+void hdmi_pkt_hf_vsif(hdmi_infoframe_t *f, uint8_t allm);
+
+// Sets ITC and content type into an existing AVI InfoFrame and updates its checksum
+void hdmi_pkt_avi_set_content_type(hdmi_infoframe_t *f, uint8_t itc, hdmi_content_type_t cn);
+
+#endif /* HDMI_PKT_H_ */
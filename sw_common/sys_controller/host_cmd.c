@@ -0,0 +1,81 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include <string.h>
+#include "hal.h"
+#include "host_cmd.h"
+#include "trace.h"
+
+#ifdef HOST_CMD_ENABLE
+
+static host_cmd_stats_t stats;
+static uint8_t frame[HOST_CMD_HDR_LEN+HOST_CMD_MAX_PAYLOAD+1];
+static uint8_t fill;
+
+int host_cmd_poll(host_cmd_t *cmd) {
+    uint32_t data;
+    uint8_t c, sum, i;
+
+    while ((data = IORD(JTAG_UART_0_BASE, JUART_DATA)) & JUART_DATA_RVALID) {
+        c = data & 0xff;
+
+        if ((fill == 0) && (c != HOST_CMD_SYNC_BYTE))
+            continue;
+
+        frame[fill++] = c;
+        if ((fill == HOST_CMD_HDR_LEN) && (frame[3] > HOST_CMD_MAX_PAYLOAD)) {
+            stats.errors++;
+            fill = 0;
+            continue;
+        }
+        if ((fill < HOST_CMD_HDR_LEN) || (fill < HOST_CMD_HDR_LEN+frame[3]+1))
+            continue;
+
+        fill = 0;
+        for (i=1, sum=0; i<HOST_CMD_HDR_LEN+frame[3]+1; i++)
+            sum += frame[i];
+        if (sum != 0) {
+            stats.errors++;
+            continue;
+        }
+
+        cmd->id = frame[1];
+        cmd->seq = frame[2];
+        cmd->len = frame[3];
+        memcpy(cmd->payload, frame+HOST_CMD_HDR_LEN, cmd->len);
+        stats.frames++;
+        return 1;
+    }
+
+    return 0;
+}
+
+void host_cmd_reply(const host_cmd_t *cmd, host_cmd_status_t status, uint32_t d0, uint32_t d1, uint32_t d2) {
+    if (status != HOST_CMD_OK)
+        stats.errors++;
+
+    TRACE4(CMD_REPLY, HOST_CMD_REPLY_HDR(cmd->seq, cmd->id, status), d0, d1, d2);
+}
+
+const host_cmd_stats_t* host_cmd_get_stats() {
+    return &stats;
+}
+
+#endif
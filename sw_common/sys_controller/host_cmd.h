@@ -0,0 +1,116 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef HOST_CMD_H_
+#define HOST_CMD_H_
+
+#include <stdint.h>
+
+// Commands need trace output for replies. system.h must be included first in firmware.
+#if defined(JTAG_UART_0_BASE) && !defined(TRACE_DISABLE)
+#define HOST_CMD_ENABLE
+#endif
+
+// Framed command protocol on JTAG UART input, shared by firmware and host encoder (sw_common/host_cmd).
+// Frame: sync byte, command ID, sequence number, payload length, payload, checksum. Checksum makes the
+// 8-bit sum of all bytes after sync byte zero. Multi-byte payload values are little-endian.
+// Each accepted frame is answered with a CMD_REPLY trace record carrying sequence number, command ID,
+// status and up to 3 data words, so replies share the trace stream (and its timestamps) with events.
+#define HOST_CMD_SYNC_BYTE      0x5A
+#define HOST_CMD_MAX_PAYLOAD    16
+#define HOST_CMD_HDR_LEN        4
+
+typedef enum {
+    HOST_CMD_PING           = 0x01,     // -> fw version, timestamp frequency, timestamp
+    HOST_CMD_SET_INPUT      = 0x02,     // u8 avinput
+    HOST_CMD_LOAD_PROFILE   = 0x03,     // u8 profile slot -> read_userdata() return value
+    HOST_CMD_WR_AVCONFIG    = 0x04,     // u16 byte offset, 1-12 bytes written to target avconfig (whitelisted fields only)
+    HOST_CMD_RD_OBJ         = 0x05,     // u8 object, u16 word offset -> object size in bytes, 2 words
+    HOST_CMD_SET_VAR        = 0x06,     // u8 variable, u32 value
+    HOST_CMD_GET_VAR        = 0x07,     // u8 variable -> value
+    HOST_CMD_RELOCK         = 0x08,     // invalidate input so that it is switched and detected again
+} host_cmd_id_t;
+
+typedef enum {
+    HOST_OBJ_VMODE_IN       = 0,
+    HOST_OBJ_VMODE_OUT      = 1,
+    HOST_OBJ_VM_CONF        = 2,
+    HOST_OBJ_AVCONFIG       = 3,        // current (applied) avconfig
+    HOST_OBJ_HEALTH         = 4,        // host_cmd_health_t
+    HOST_OBJ_EMIF_PERF      = 5,        // LM EMIF bandwidth/latency of last window (DE10-Nano)
+    HOST_NUM_OBJS
+} host_obj_id_t;
+
+typedef enum {
+    HOST_VAR_STRESS_MODE    = 0,
+    HOST_VAR_FB_CAPTURE_REQ = 1,
+    HOST_VAR_VRR_ENABLE     = 2,
+    HOST_VAR_AUD_MCLK_TRACK = 3,
+    HOST_VAR_LM_PREFETCH    = 4,
+    HOST_VAR_FW_UPDATE_REQ  = 5,
+    HOST_VAR_OUT_HOLD       = 6,
+    HOST_VAR_HDMI_GAME      = 7,        // HDMI_GAME_* flags (ADV7513 boards)
+    HOST_NUM_VARS
+} host_var_id_t;
+
+typedef enum {
+    HOST_CMD_OK             = 0,
+    HOST_CMD_ERR_CMD        = 1,        // unknown command
+    HOST_CMD_ERR_ARG        = 2,        // malformed payload or value out of range
+    HOST_CMD_ERR_FAIL       = 3,        // command was run but failed
+} host_cmd_status_t;
+
+#define HOST_CMD_REPLY_HDR(seq, cmd, status)    ((uint32_t)(seq) | ((uint32_t)(cmd) << 8) | ((uint32_t)(status) << 16))
+
+typedef struct {
+    uint32_t timestamp;
+    uint32_t vip_cvi_overflows;
+    uint32_t vip_cvo_underflows;
+    uint32_t mainloop_overruns;
+    uint32_t trace_lost;
+    uint32_t cmd_frames;
+    uint32_t cmd_errors;
+    uint8_t avinput;
+    uint8_t sync_active;
+    int8_t oper_mode;
+    uint8_t framelock;
+} host_cmd_health_t;
+
+typedef struct {
+    uint8_t id;
+    uint8_t seq;
+    uint8_t len;
+    uint8_t payload[HOST_CMD_MAX_PAYLOAD];
+} host_cmd_t;
+
+typedef struct {
+    uint32_t frames;
+    uint32_t errors;
+} host_cmd_stats_t;
+
+// Returns 1 and next complete frame received from host, or 0 when none is pending.
+// Frames with bad checksum or length are dropped and counted as errors.
+int host_cmd_poll(host_cmd_t *cmd);
+
+void host_cmd_reply(const host_cmd_t *cmd, host_cmd_status_t status, uint32_t d0, uint32_t d1, uint32_t d2);
+
+const host_cmd_stats_t* host_cmd_get_stats();
+
+#endif /* HOST_CMD_H_ */
@@ -0,0 +1,60 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "hal.h"
+#include "i2c_opencores.h"
+#include "i2c_stats.h"
+#include "trace.h"
+
+// Call the real driver entry points below, not the redirections from hal_i2c.h
+#undef I2C_start
+#undef I2C_read
+#undef I2C_write
+
+volatile uint32_t i2c_xfer_bytes;
+uint32_t i2c_bytes_per_period;
+
+int hal_i2c_start(uint32_t base, uint32_t add, uint32_t read) {
+    int ret;
+
+    i2c_xfer_bytes++;
+    ret = I2C_start(base, add, read);
+    if (ret)
+        TRACE2(I2C_NACK, base, add);
+
+    return ret;
+}
+
+uint32_t hal_i2c_read(uint32_t base, uint32_t last) {
+    i2c_xfer_bytes++;
+    return I2C_read(base, last);
+}
+
+uint32_t hal_i2c_write(uint32_t base, uint8_t data, uint32_t last) {
+    i2c_xfer_bytes++;
+    return I2C_write(base, data, last);
+}
+
+void i2c_stats_update_period() {
+    static uint32_t i2c_xfer_bytes_prev;
+    uint32_t bytes = i2c_xfer_bytes;
+
+    i2c_bytes_per_period = bytes - i2c_xfer_bytes_prev;
+    i2c_xfer_bytes_prev = bytes;
+}
@@ -0,0 +1,34 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef I2C_STATS_H_
+#define I2C_STATS_H_
+
+#include <stdint.h>
+
+// Bytes (incl. address bytes) transferred over all I2C masters. Updated by
+// the hal_i2c_start/hal_i2c_read/hal_i2c_write shims (see hal_i2c.h).
+extern volatile uint32_t i2c_xfer_bytes;
+
+// Bytes transferred during the last full measurement period
+extern uint32_t i2c_bytes_per_period;
+
+void i2c_stats_update_period();
+
+#endif /* I2C_STATS_H_ */
@@ -0,0 +1,97 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include "int_scale.h"
+
+uint8_t int_scale_enable = INT_SCALE_FASTPATH_DEFAULT;
+
+static int int_scale_nearest(avconfig_t *avconfig, mode_data_t *vm_in) {
+    // same selection as update_sc_config() uses for VIP scaler coefficients
+    if (avconfig->scl_alg == 0)
+        return (vm_in->group >= GROUP_240P) && (vm_in->group <= GROUP_288P);
+
+    return (avconfig->scl_alg < SCL_ALG_COEFF_START);
+}
+
+uint16_t lm_framesync_line(mode_data_t *vm_in, mode_data_t *vm_out, vm_proc_config_t *vm_conf, uint8_t fmult) {
+    uint32_t in_vt = vm_in->timings.v_total;
+    uint32_t out_vt = vm_out->timings.v_total*fmult;
+    uint32_t y_mult = vm_conf->y_rpt+1;
+    uint32_t in_v = vm_conf->y_size/y_mult;
+    uint32_t in_start, out_start;
+    int32_t lag_first, lag_last, lag;
+
+    if (!in_v)
+        return 0;
+
+    // Pick the smallest input line lag for output SOF so that no input line is read before it has been
+    // written. With framelock one output line lasts in_vt/out_vt input lines where out_vt covers all fmult output
+    // frames, and since both progress linearly it is enough to check the first and the last active line (in
+    // units of 1/out_vt lines). Only the first output frame of each input frame is constrained.
+    in_start = vm_in->timings.v_synclen + vm_in->timings.v_backporch + vm_conf->y_start_lb;
+    out_start = vm_out->timings.v_synclen + vm_out->timings.v_backporch + vm_conf->y_offset;
+    lag_first = (int32_t)((in_start+1)*out_vt) - (int32_t)(out_start*in_vt);
+    lag_last = (int32_t)((in_start+in_v)*out_vt) - (int32_t)((out_start+(in_v-1)*y_mult)*in_vt);
+    lag = (lag_first > lag_last) ? lag_first : lag_last;
+
+    return (lag > 0) ? (lag+out_vt-1)/out_vt : 0;
+}
+
+oper_mode_t int_scale_select(avconfig_t *avconfig, oper_mode_t oper_mode, mode_data_t *vm_in, mode_data_t *vm_out, vm_proc_config_t *vm_conf) {
+    uint32_t in_h = vm_in->timings.h_active;
+    uint32_t in_v = vm_in->timings.v_active;
+    uint32_t in_vt = vm_in->timings.v_total;
+    uint32_t out_vt = vm_out->timings.v_total;
+    uint32_t x_mult, y_mult, vdiff;
+
+    if (!int_scale_enable || (oper_mode != OPERMODE_SCALER) || !int_scale_nearest(avconfig, vm_in))
+        return oper_mode;
+
+    // LM path does not deinterlace into a different field structure
+    if (vm_in->timings.interlaced || vm_out->timings.interlaced || !in_h || !in_v || !in_vt || !out_vt || !vm_in->timings.v_hz_x100)
+        return oper_mode;
+
+    if ((vm_conf->x_size % in_h) || (vm_conf->y_size % in_v) ||
+        (vm_conf->x_size > vm_out->timings.h_active) || (vm_conf->y_size > vm_out->timings.v_active))
+        return oper_mode;
+
+    x_mult = vm_conf->x_size / in_h;
+    y_mult = vm_conf->y_size / in_v;
+    if (!x_mult || (x_mult > INT_SCALE_MAX_MULT) || !y_mult || (y_mult > INT_SCALE_MAX_MULT))
+        return oper_mode;
+
+    // output frame rate gets locked to input, so nominal rates must be close
+    vdiff = (vm_out->timings.v_hz_x100 > vm_in->timings.v_hz_x100) ? vm_out->timings.v_hz_x100-vm_in->timings.v_hz_x100 : vm_in->timings.v_hz_x100-vm_out->timings.v_hz_x100;
+    if (vdiff*1000 > INT_SCALE_MAX_VDIFF_X1000*vm_in->timings.v_hz_x100)
+        return oper_mode;
+
+    vm_conf->x_rpt = x_mult-1;
+    vm_conf->y_rpt = y_mult-1;
+    vm_conf->x_offset = (vm_out->timings.h_active-vm_conf->x_size)/2;
+    vm_conf->y_offset = (vm_out->timings.v_active-vm_conf->y_size)/2;
+    vm_conf->x_start_lb = 0;
+    vm_conf->y_start_lb = 0;
+    vm_conf->framelock = 1;
+    vm_conf->si_pclk_mult = 0;
+
+    vm_conf->framesync_line = lm_framesync_line(vm_in, vm_out, vm_conf, 1);
+
+    return OPERMODE_ADAPT_LM;
+}
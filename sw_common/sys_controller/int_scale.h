@@ -0,0 +1,53 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef INT_SCALE_H_
+#define INT_SCALE_H_
+
+#include <stdint.h>
+#include "avconfig.h"
+#include "video_modes.h"
+
+// scl_alg values below this select built-in nearest neighbour coefficients
+#define SCL_ALG_COEFF_START 3
+
+// Largest per-axis repeat factor handled by scanconverter line multiplier
+#define INT_SCALE_MAX_MULT  6
+
+// Max deviation of output refresh from input refresh which framelock can absorb (x1000)
+#define INT_SCALE_MAX_VDIFF_X1000   20
+
+#ifndef INT_SCALE_FASTPATH_DEFAULT
+#define INT_SCALE_FASTPATH_DEFAULT 1
+#endif
+
+extern uint8_t int_scale_enable;
+
+// Smallest framesync line (input line count from SOF) for a locked LM mode whose output frame is scanned
+// fmult times per input frame, such that the first output frame reads each line right after it is written
+uint16_t lm_framesync_line(mode_data_t *vm_in, mode_data_t *vm_out, vm_proc_config_t *vm_conf, uint8_t fmult);
+
+// Reroutes scaler mode through scanconverter line multiplier (x_rpt/y_rpt with centring offsets and
+// adaptive framesync) when VIP would only do integer nearest neighbour scaling. This gives line-level
+// latency and frees DDR bandwidth used by VIP frame buffer. Returns OPERMODE_ADAPT_LM and updates
+// vm_conf if fast path was taken, otherwise oper_mode as-is.
+oper_mode_t int_scale_select(avconfig_t *avconfig, oper_mode_t oper_mode, mode_data_t *vm_in, mode_data_t *vm_out, vm_proc_config_t *vm_conf);
+
+#endif /* INT_SCALE_H_ */
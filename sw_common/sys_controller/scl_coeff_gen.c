@@ -0,0 +1,257 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <string.h>
+#include "scl_coeff_gen.h"
+
+// Kernel profile is sampled in steps of 1/PROF_RES over [0, PROF_SUPPORT) and linearly interpolated
+#define PROF_RES_BITS   5
+#define PROF_RES        (1<<PROF_RES_BITS)
+#define PROF_SUPPORT    4
+#define PROF_LEN        (PROF_SUPPORT*PROF_RES+1)
+#define PROF_ONE        (1<<14)
+
+#define PI2_Q8          2527    // pi^2
+#define LOG2E_Q8        369     // log2(e)
+
+// sin(pi*i/128), i=0..64, Q15
+static const int16_t sin_pi_lut[65] = {
+        0,   804,  1608,  2411,  3212,  4011,  4808,  5602,
+     6393,  7180,  7962,  8740,  9512, 10279, 11039, 11793,
+    12540, 13279, 14010, 14733, 15447, 16151, 16846, 17531,
+    18205, 18868, 19520, 20160, 20788, 21403, 22006, 22595,
+    23170, 23732, 24279, 24812, 25330, 25833, 26320, 26791,
+    27246, 27684, 28106, 28511, 28899, 29269, 29622, 29957,
+    30274, 30572, 30853, 31114, 31357, 31581, 31786, 31972,
+    32138, 32286, 32413, 32522, 32610, 32679, 32729, 32758,
+    32767,
+};
+
+// 2^(-k/16), k=0..16, Q15
+static const uint16_t exp2_neg_lut[17] = {
+    32768, 31379, 30048, 28774, 27554, 26386, 25268, 24196, 23170,
+    22188, 21247, 20347, 19484, 18658, 17867, 17109, 16384,
+};
+
+typedef struct {
+    uint8_t valid;
+    uint8_t scale_q8;
+    uint16_t lru;
+    scl_gen_params_t par;
+    scl_gen_coeffs_t coeffs;
+} scl_gen_cache_entry_t;
+
+static scl_gen_cache_entry_t scl_gen_cache[SCL_GEN_CACHE_SIZE];
+static uint16_t scl_gen_lru_ctr;
+
+static scl_gen_params_t prof_par;
+static uint8_t prof_valid;
+static int16_t prof[PROF_LEN];
+
+// sin(pi*x), x in Q16, result in Q15
+static int32_t isin_pi(uint32_t x_q16) {
+    int neg = (x_q16 >> 16) & 0x1;
+    uint32_t xm = x_q16 & 0xffff;
+    uint32_t idx, frac;
+    int32_t y;
+
+    if (xm > 0x8000)
+        xm = 0x10000 - xm;
+
+    idx = xm >> 9;
+    frac = xm & 0x1ff;
+    y = sin_pi_lut[idx];
+    if (idx < 64)
+        y += ((sin_pi_lut[idx+1] - sin_pi_lut[idx]) * (int32_t)frac) >> 9;
+
+    return neg ? -y : y;
+}
+
+// 2^(-z), z in Q16, result in Q14
+static int32_t iexp2_neg(uint32_t z_q16) {
+    uint32_t n = z_q16 >> 16;
+    uint32_t f = (z_q16 & 0xffff) >> 12;
+    uint32_t frac = z_q16 & 0xfff;
+    int32_t y;
+
+    if (n >= 15)
+        return 0;
+
+    y = exp2_neg_lut[f] - (((exp2_neg_lut[f] - exp2_neg_lut[f+1]) * frac) >> 12);
+
+    return (y >> n) >> 1;
+}
+
+// Evaluate kernel at x = i/PROF_RES into Q14
+static int32_t kernel_sample(const scl_gen_params_t *par, uint32_t i) {
+    uint32_t a, p, d, x_q16, y_q16;
+    int32_t b, c, x, x2, x3, v;
+
+    switch (par->kernel) {
+    case SCL_GEN_LANCZOS:
+        a = (par->p1 < 2) ? 2 : ((par->p1 > PROF_SUPPORT) ? PROF_SUPPORT : par->p1);
+        if (i == 0)
+            return PROF_ONE;
+        if (i >= a*PROF_RES)
+            return 0;
+
+        // a*sin(pi*x)*sin(pi*x/a) / (pi^2*x^2)
+        x_q16 = i << (16-PROF_RES_BITS);
+        v = (isin_pi(x_q16) * isin_pi(x_q16/a)) >> 15;
+        p = (uint32_t)((v < 0) ? -v : v) * a;
+        d = (PI2_Q8*i*i + 4) >> 3;
+        return (v < 0) ? -(int32_t)((p << 14) / d) : (int32_t)((p << 14) / d);
+    case SCL_GEN_MITCHELL:
+        // Q14 B/C, polynomials evaluated for 6*k(x) and scaled by 1/6 at the end
+        b = (par->p1 * PROF_ONE) / 100;
+        c = (par->p2 * PROF_ONE) / 100;
+        x = i << (14-PROF_RES_BITS);
+        if (x >= 2*PROF_ONE)
+            return 0;
+        x2 = (x*x) >> 14;
+        x3 = ((int64_t)x2*x) >> 14;
+        if (x < PROF_ONE)
+            v = (((int64_t)(12*PROF_ONE - 9*b - 6*c) * x3) >> 14) + (((int64_t)(-18*PROF_ONE + 12*b + 6*c) * x2) >> 14) + 6*PROF_ONE - 2*b;
+        else
+            v = (((int64_t)(-b - 6*c) * x3) >> 14) + (((int64_t)(6*b + 30*c) * x2) >> 14) + (((int64_t)(-12*b - 48*c) * x) >> 14) + 8*b + 24*c;
+        return (v * 10923) >> 16;
+    case SCL_GEN_GAUSSIAN:
+        // exp(-x^2/(2*sigma^2)) = 2^(-log2(e)*x^2/(2*sigma^2))
+        p = (par->p1 < 10) ? 10 : par->p1;
+        y_q16 = (i*i*((10000U << (16-1-2*PROF_RES_BITS)) / p)) / p;
+        return iexp2_neg((y_q16 >> 8) * LOG2E_Q8);
+    default:
+        return (i < PROF_RES/2) ? PROF_ONE : 0;
+    }
+}
+
+static void update_profile(const scl_gen_params_t *par) {
+    uint32_t i;
+
+    if (prof_valid && !memcmp(&prof_par, par, sizeof(scl_gen_params_t)))
+        return;
+
+    for (i=0; i<PROF_LEN; i++)
+        prof[i] = kernel_sample(par, i);
+
+    memcpy(&prof_par, par, sizeof(scl_gen_params_t));
+    prof_valid = 1;
+}
+
+static uint8_t get_scale_q8(uint16_t src_size, uint16_t dst_size) {
+    uint32_t s;
+
+    if ((src_size == 0) || (dst_size >= src_size))
+        return 0;
+
+    // kernel cannot be widened beyond 4-tap support, so downscales deeper than 2:1 partially alias
+    s = ((uint32_t)dst_size << 8) / src_size;
+    return (s < 128) ? 128 : s;
+}
+
+static int gen_coeffs_scaled(const scl_gen_params_t *par, uint8_t scale_q8, scl_gen_coeffs_t *coeffs) {
+    uint32_t s_q8 = scale_q8 ? scale_q8 : 256;
+    int32_t d, x, pos, w[SCL_GEN_TAPS], sum, recip, nsum, tmax;
+    int p, t;
+
+    if (par->kernel >= SCL_GEN_NUM_KERNELS)
+        return -1;
+
+    update_profile(par);
+
+    // Kernel is symmetric, so only phases 0..PHASES/2 are evaluated and the rest are mirrored
+    for (p=0; p<=SCL_GEN_PHASES/2; p++) {
+        sum = 0;
+        for (t=0; t<SCL_GEN_TAPS; t++) {
+            d = ((t-1) << 16) - (p << 10);
+            x = (((d < 0) ? -d : d) * s_q8) >> 8;
+            pos = x >> (16-PROF_RES_BITS);
+            if (pos >= PROF_LEN-1) {
+                w[t] = 0;
+            } else {
+                w[t] = prof[pos] + (((prof[pos+1] - prof[pos]) * (x & ((1<<(16-PROF_RES_BITS))-1))) >> (16-PROF_RES_BITS));
+            }
+            sum += w[t];
+        }
+
+        if (sum < PROF_ONE/4)
+            return -1;
+
+        tmax = 0;
+        for (t=1; t<SCL_GEN_TAPS; t++) {
+            if (w[t] > w[tmax])
+                tmax = t;
+        }
+
+        recip = ((1<<SCL_GEN_FRAC_BITS) << 20) / sum;
+        nsum = 0;
+        for (t=0; t<SCL_GEN_TAPS; t++) {
+            coeffs->v[p][t] = (w[t]*recip + (1<<19)) >> 20;
+            nsum += coeffs->v[p][t];
+        }
+        // put rounding residual into the dominant tap so that DC gain is exactly unity
+        coeffs->v[p][tmax] += (1<<SCL_GEN_FRAC_BITS) - nsum;
+
+        if ((p > 0) && (p < SCL_GEN_PHASES/2)) {
+            for (t=0; t<SCL_GEN_TAPS; t++)
+                coeffs->v[SCL_GEN_PHASES-p][t] = coeffs->v[p][SCL_GEN_TAPS-1-t];
+        }
+    }
+
+    return 0;
+}
+
+int scl_gen_coeffs(const scl_gen_params_t *par, uint16_t src_size, uint16_t dst_size, scl_gen_coeffs_t *coeffs) {
+    return gen_coeffs_scaled(par, get_scale_q8(src_size, dst_size), coeffs);
+}
+
+const scl_gen_coeffs_t* scl_gen_get_coeffs(const scl_gen_params_t *par, uint16_t src_size, uint16_t dst_size) {
+    uint8_t scale_q8 = get_scale_q8(src_size, dst_size);
+    scl_gen_cache_entry_t *e, *victim = &scl_gen_cache[0];
+    int i;
+
+    for (i=0; i<SCL_GEN_CACHE_SIZE; i++) {
+        e = &scl_gen_cache[i];
+        if (e->valid && (e->scale_q8 == scale_q8) && !memcmp(&e->par, par, sizeof(scl_gen_params_t))) {
+            e->lru = ++scl_gen_lru_ctr;
+            return &e->coeffs;
+        }
+
+        if (!e->valid)
+            victim = e;
+        else if (victim->valid && ((uint16_t)(scl_gen_lru_ctr - e->lru) > (uint16_t)(scl_gen_lru_ctr - victim->lru)))
+            victim = e;
+    }
+
+    victim->valid = 0;
+    if (gen_coeffs_scaled(par, scale_q8, &victim->coeffs) != 0)
+        return NULL;
+
+    memcpy(&victim->par, par, sizeof(scl_gen_params_t));
+    victim->scale_q8 = scale_q8;
+    victim->lru = ++scl_gen_lru_ctr;
+    victim->valid = 1;
+
+    return &victim->coeffs;
+}
+
+void scl_gen_flush_cache() {
+    memset(scl_gen_cache, 0, sizeof(scl_gen_cache));
+    prof_valid = 0;
+}
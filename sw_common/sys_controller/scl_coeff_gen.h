@@ -0,0 +1,61 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef SCL_COEFF_GEN_H_
+#define SCL_COEFF_GEN_H_
+
+#include <stdint.h>
+#include "sysconfig.h"
+
+// Must match VIP Scaler II configuration (4 taps, 64 phases, s1.7 coefficients)
+#define SCL_GEN_TAPS        4
+#define SCL_GEN_PHASES      64
+#define SCL_GEN_FRAC_BITS   7
+
+#ifndef SCL_GEN_CACHE_SIZE
+#define SCL_GEN_CACHE_SIZE  4
+#endif
+
+typedef enum {
+    SCL_GEN_LANCZOS     = 0,    // p1: number of lobes (2-4)
+    SCL_GEN_MITCHELL    = 1,    // p1: B x100, p2: C x100
+    SCL_GEN_GAUSSIAN    = 2,    // p1: sigma x100
+    SCL_GEN_NUM_KERNELS
+} scl_gen_kernel_t;
+
+typedef struct {
+    uint8_t kernel;
+    uint8_t p1;
+    uint8_t p2;
+} scl_gen_params_t;
+
+typedef struct {
+    int16_t v[SCL_GEN_PHASES][SCL_GEN_TAPS];
+} scl_gen_coeffs_t;
+
+// Integer-only generator. Kernel is widened by src/dst when downscaling so that it acts as a lowpass
+// filter for the output sampling rate; upscales use the kernel as-is. Returns 0 on success.
+int scl_gen_coeffs(const scl_gen_params_t *par, uint16_t src_size, uint16_t dst_size, scl_gen_coeffs_t *coeffs);
+
+// Returns coefficient set from cache, generating it (and evicting least recently used entry) if needed
+const scl_gen_coeffs_t* scl_gen_get_coeffs(const scl_gen_params_t *par, uint16_t src_size, uint16_t dst_size);
+
+void scl_gen_flush_cache();
+
+#endif /* SCL_COEFF_GEN_H_ */
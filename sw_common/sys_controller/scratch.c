@@ -0,0 +1,73 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include <stdio.h>
+#include "sysconfig.h"
+#include "fw_update.h"
+#include "scratch.h"
+
+// Largest user must fit together with FIL (~560B with 512B sectors): update double buffer
+// where SD update is supported, otherwise text parsing (line buffer + custom shadow mask).
+#ifndef SCRATCH_SIZE
+#ifdef FW_UPDATE_BOARD_ID
+#define SCRATCH_SIZE    (2*FW_UPDATE_CHUNK_SIZE + 768)
+#else
+#define SCRATCH_SIZE    1536
+#endif
+#endif
+
+static uint8_t scratch_arena[SCRATCH_SIZE] __attribute__((section(".scratch"), aligned(SCRATCH_ALIGN)));
+static uint32_t scratch_pos;
+static uint32_t scratch_peak_pos;
+
+void* scratch_alloc(uint32_t size) {
+    void *p;
+
+    size = (size + SCRATCH_ALIGN - 1) & ~(SCRATCH_ALIGN - 1);
+
+    if (size > SCRATCH_SIZE - scratch_pos) {
+        printf("Scratch exhausted (%lu+%lu/%u)\n", scratch_pos, size, SCRATCH_SIZE);
+        return NULL;
+    }
+
+    p = &scratch_arena[scratch_pos];
+    scratch_pos += size;
+    if (scratch_pos > scratch_peak_pos)
+        scratch_peak_pos = scratch_pos;
+
+    return p;
+}
+
+scratch_mark_t scratch_mark() {
+    return scratch_pos;
+}
+
+void scratch_release(scratch_mark_t mark) {
+    if (mark <= scratch_pos)
+        scratch_pos = mark;
+}
+
+uint32_t scratch_size() {
+    return SCRATCH_SIZE;
+}
+
+uint32_t scratch_peak() {
+    return scratch_peak_pos;
+}
@@ -0,0 +1,49 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef SCRATCH_H_
+#define SCRATCH_H_
+
+#include <stdint.h>
+
+// Transient buffers (FatFs file objects, text line buffers, parsed custom tables, firmware
+// update and capture buffers) are allocated from a single arena placed in .scratch linker
+// section. Allocation is LIFO: take a mark before first allocation of an operation and
+// release it when the operation is done. Nothing allocated here may be kept across mainloop
+// iterations.
+
+#define SCRATCH_ALIGN       8
+#define SCRATCH_LINE_LEN    256
+
+typedef uint32_t scratch_mark_t;
+
+// Returns SCRATCH_ALIGN aligned block, or NULL if arena is exhausted
+void* scratch_alloc(uint32_t size);
+
+scratch_mark_t scratch_mark();
+
+// Frees everything allocated after the mark was taken
+void scratch_release(scratch_mark_t mark);
+
+// Arena size and highest usage since boot
+uint32_t scratch_size();
+uint32_t scratch_peak();
+
+#endif /* SCRATCH_H_ */
@@ -0,0 +1,241 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include "si_ratio.h"
+
+static uint32_t gcd32(uint32_t a, uint32_t b) {
+    uint32_t t;
+
+    while (b) {
+        t = a % b;
+        a = b;
+        b = t;
+    }
+
+    return a;
+}
+
+static uint64_t absdiff64(uint64_t a, uint64_t b) {
+    return (a > b) ? a-b : b-a;
+}
+
+// Best rational approximation p/q of n/d with q <= qmax. Walks continued fraction convergents and
+// checks the last semiconvergent before denominator limit is exceeded. n*qmax must fit in 64 bits.
+static void best_rational(uint64_t n, uint64_t d, uint32_t qmax, uint64_t *p, uint64_t *q) {
+    uint64_t p0=0, q0=1, p1=1, q1=0, p2, q2, a, k, ps, qs, t;
+    uint64_t n_orig = n, d_orig = d;
+
+    while (d) {
+        a = n / d;
+        q2 = q0 + a*q1;
+        if (q2 > qmax) {
+            k = (qmax - q0) / q1;
+            ps = p0 + k*p1;
+            qs = q0 + k*q1;
+            // Compare against the original ratio, not the running remainders. Both scaled errors
+            // (|N*qs-ps*D|*q1 and |N*q1-p1*D|*qs) stay below D*qmax.
+            if (absdiff64(n_orig*qs, ps*d_orig)*q1 < absdiff64(n_orig*q1, p1*d_orig)*qs) {
+                p1 = ps;
+                q1 = qs;
+            }
+            break;
+        }
+        p2 = p0 + a*p1;
+        p0 = p1;
+        q0 = q1;
+        p1 = p2;
+        q1 = q2;
+        t = n - a*d;
+        n = d;
+        d = t;
+    }
+
+    *p = p1;
+    *q = q1;
+}
+
+// |pos-neg|/den in parts per trillion, rounded up so that any residual error stays visible
+static int32_t err_ppt(uint64_t pos, uint64_t neg, uint64_t den) {
+    uint64_t diff = absdiff64(pos, neg);
+    uint64_t ppt, rem;
+    int i;
+
+    if (diff == 0)
+        return 0;
+
+    // keep remainder scaling below within 64 bits
+    while (den >= (1ULL<<56)) {
+        den >>= 1;
+        diff = (diff >> 1) | 1;
+    }
+
+    ppt = (diff*1000000000ULL) / den;
+    rem = (diff*1000000000ULL) % den;
+    for (i=0; i<3; i++) {
+        ppt = ppt*10 + (rem*10)/den;
+        rem = (rem*10) % den;
+    }
+    if (rem)
+        ppt++;
+
+    if (ppt > 0x7fffffffULL)
+        ppt = 0x7fffffffULL;
+
+    return (pos >= neg) ? (int32_t)ppt : -(int32_t)ppt;
+}
+
+static int is_better(const si_ratio_t *cand, const si_ratio_t *best, int best_valid) {
+    uint32_t ce = (cand->err_ppt < 0) ? -cand->err_ppt : cand->err_ppt;
+    uint32_t be = (best->err_ppt < 0) ? -best->err_ppt : best->err_ppt;
+
+    if (!best_valid)
+        return 1;
+    if (cand->exact != best->exact)
+        return cand->exact;
+
+    return ce < be;
+}
+
+int si_ratio_clkin_div(uint32_t clkin_hz) {
+    int div;
+
+    for (div=0; div<=SI_RATIO_CLKIN_DIV_MAX; div++) {
+        if (clkin_hz <= ((uint64_t)SI_RATIO_PLL_IN_MAX_HZ << div))
+            return div;
+    }
+
+    return -1;
+}
+
+int si_ratio_search(uint32_t clkin_hz, uint32_t num, uint32_t den, si_ratio_t *r) {
+    uint64_t fout_hz, p, q;
+    uint32_t ref_hz, g, d, d_lo, d_hi, m, m_lo, m_hi;
+    si_ratio_t c;
+    int i, clkin_div, valid = 0;
+
+    if ((clkin_hz == 0) || (num == 0) || (den == 0))
+        return -1;
+
+    clkin_div = si_ratio_clkin_div(clkin_hz);
+    if (clkin_div < 0)
+        return -1;
+
+    g = gcd32(num, den);
+    num /= g;
+    den /= g;
+
+    // Ratio relative to divided PLL reference is num*2^clkin_div/den
+    for (i=0; i<clkin_div; i++) {
+        if ((den & 1) == 0)
+            den >>= 1;
+        else if (num & 0x80000000)
+            return -1;
+        else
+            num <<= 1;
+    }
+
+    ref_hz = clkin_hz >> clkin_div;
+    c.clkin_div = clkin_div;
+
+    fout_hz = ((uint64_t)ref_hz*num) / den;
+    if (fout_hz == 0)
+        return -1;
+
+    // Integer multisynth, fractional PLL: PLL = num*d/den
+    d_lo = (SI_RATIO_VCO_MIN_HZ + fout_hz - 1) / fout_hz;
+    d_hi = SI_RATIO_VCO_MAX_HZ / fout_hz;
+    if (d_lo < SI_RATIO_MS_MIN)
+        d_lo = SI_RATIO_MS_MIN;
+    if (d_hi > SI_RATIO_MS_MAX)
+        d_hi = SI_RATIO_MS_MAX;
+
+    for (d=d_lo; d<=d_hi; d++) {
+        best_rational((uint64_t)num*d, den, SI_RATIO_DENOM_MAX, &p, &q);
+        c.pll_a = p / q;
+        c.pll_b = p % q;
+        c.pll_c = q;
+        if ((c.pll_a < SI_RATIO_PLL_MIN) || (c.pll_a > SI_RATIO_PLL_MAX) || ((c.pll_a == SI_RATIO_PLL_MAX) && c.pll_b))
+            continue;
+        c.ms_a = d;
+        c.ms_b = 0;
+        c.ms_c = 1;
+        c.exact = (p*den == q*num*d);
+        c.err_ppt = err_ppt(p*den, q*num*d, q*num*d);
+
+        if (is_better(&c, r, valid)) {
+            *r = c;
+            valid = 1;
+            if (c.exact)
+                return 0;
+        }
+    }
+
+    // Integer PLL, fractional multisynth: MS = den*m/num
+    m_lo = (SI_RATIO_VCO_MIN_HZ + ref_hz - 1) / ref_hz;
+    m_hi = SI_RATIO_VCO_MAX_HZ / ref_hz;
+    if (m_lo < SI_RATIO_PLL_MIN)
+        m_lo = SI_RATIO_PLL_MIN;
+    if (m_hi > SI_RATIO_PLL_MAX)
+        m_hi = SI_RATIO_PLL_MAX;
+
+    for (m=m_lo; m<=m_hi; m++) {
+        best_rational((uint64_t)den*m, num, SI_RATIO_DENOM_MAX, &p, &q);
+        c.ms_a = p / q;
+        c.ms_b = p % q;
+        c.ms_c = q;
+        if ((c.ms_a < SI_RATIO_MS_MIN) || (c.ms_a > SI_RATIO_MS_MAX) || ((c.ms_a == SI_RATIO_MS_MAX) && c.ms_b))
+            continue;
+        c.pll_a = m;
+        c.pll_b = 0;
+        c.pll_c = 1;
+        c.exact = ((uint64_t)m*q*den == p*num);
+        c.err_ppt = err_ppt((uint64_t)m*q*den, p*num, p*num);
+
+        if (is_better(&c, r, valid)) {
+            *r = c;
+            valid = 1;
+            if (c.exact)
+                return 0;
+        }
+    }
+
+    return valid ? 0 : -1;
+}
+
+void si_ratio_to_p(uint32_t a, uint32_t b, uint32_t c, uint32_t p[3]) {
+    uint32_t f = (128*b) / c;
+
+    p[0] = 128*a + f - 512;
+    p[1] = 128*b - c*f;
+    p[2] = c;
+}
+
+uint32_t si_ratio_resync_sec(const si_ratio_t *r, uint32_t h_out_hz) {
+    uint64_t err = (r->err_ppt < 0) ? -(int64_t)r->err_ppt : r->err_ppt;
+    uint64_t sec;
+
+    if (r->exact || (err == 0) || (h_out_hz == 0))
+        return 0xffffffff;
+
+    // output drifts err*h_out_hz lines per second relative to input
+    sec = (SI_RATIO_RESYNC_LINES*1000000000000ULL) / (err*h_out_hz);
+
+    return (sec > 0xfffffffeULL) ? 0xfffffffe : (uint32_t)sec;
+}
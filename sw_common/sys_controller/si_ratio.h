@@ -0,0 +1,69 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef SI_RATIO_H_
+#define SI_RATIO_H_
+
+#include <stdint.h>
+
+// Si5351 limits: PLL feedback a+b/c and multisynth a+b/c with 20-bit denominators
+#define SI_RATIO_DENOM_MAX  1048575UL
+#define SI_RATIO_PLL_MIN    15
+#define SI_RATIO_PLL_MAX    90
+#define SI_RATIO_MS_MIN     8
+#define SI_RATIO_MS_MAX     2048
+#define SI_RATIO_VCO_MIN_HZ 600000000ULL
+#define SI_RATIO_VCO_MAX_HZ 900000000ULL
+
+// PLL input must not exceed 40MHz, so faster CLKIN is divided by 2^CLKIN_DIV (up to 8) first
+#define SI_RATIO_PLL_IN_MAX_HZ  40000000UL
+#define SI_RATIO_CLKIN_DIV_MAX  3
+
+// Phase drift (in output lines) that framelock logic tolerates before restarting output frame.
+// Actual threshold is set by scanconverter RTL, so resync interval is an estimate.
+#ifndef SI_RATIO_RESYNC_LINES
+#define SI_RATIO_RESYNC_LINES 1
+#endif
+
+typedef struct {
+    uint32_t pll_a, pll_b, pll_c;
+    uint32_t ms_a, ms_b, ms_c;
+    uint8_t clkin_div;  // CLKIN_DIV field, PLL reference is CLKIN/2^clkin_div
+    uint8_t exact;
+    int32_t err_ppt;    // achieved/requested ratio - 1 in 1e-12 units, rounded away from zero when inexact
+} si_ratio_t;
+
+// Searches PLL and multisynth a+b/c pair for which CLKIN*num/den is reproduced by CLKIN/2^clkin_div*PLL/MS
+// as closely as possible. CLKIN divider is the smallest one that keeps PLL input within range. One stage
+// is kept integer while the other is fitted by continued fraction expansion with bounded denominator, and
+// all VCO-valid integer values of the former are tried. Returns 0 on success, -1 if no valid configuration
+// exists (e.g. output beyond VCO_MAX/MS_MIN or CLKIN too fast even when divided by 8).
+int si_ratio_search(uint32_t clkin_hz, uint32_t num, uint32_t den, si_ratio_t *r);
+
+// CLKIN_DIV value (log2 of divider) which brings given CLKIN within PLL input range, -1 if none does
+int si_ratio_clkin_div(uint32_t clkin_hz);
+
+// Encode a+b/c into Si5351 register parameters P1..P3
+void si_ratio_to_p(uint32_t a, uint32_t b, uint32_t c, uint32_t p[3]);
+
+// Predicted seconds between framelock resyncs for given line rate, 0xffffffff if ratio is exact
+uint32_t si_ratio_resync_sec(const si_ratio_t *r, uint32_t h_out_hz);
+
+#endif /* SI_RATIO_H_ */
@@ -18,13 +18,13 @@
 //
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
 #include <unistd.h>
 #include <string.h>
 #include "i2c_opencores.h"
-#include "altera_avalon_pio_regs.h"
-#include "altera_avalon_timer.h"
-#include <sys/alt_timestamp.h>
 #include "system.h"
+#include "hal.h"
 #include "bscanf.h"
 #include "isl51002.h"
 #ifdef INC_ADV7513
@@ -39,12 +39,25 @@
 #include "menu.h"
 #include "mmc.h"
 #include "file.h"
+#include "diskio.h"
 #include "controls.h"
 #include "avconfig.h"
 #include "av_controller.h"
 #include "video_modes.h"
 #include "flash.h"
 #include "userdata.h"
+#include "scl_coeff_gen.h"
+#include "i2c_stats.h"
+#include "fb_capture.h"
+#include "ctrl_events.h"
+#include "trace.h"
+#include "int_scale.h"
+#include "frame_mult.h"
+#include "fw_update.h"
+#include "host_cmd.h"
+#include "hdmi_pkt.h"
+#include "si_ratio.h"
+#include "scratch.h"
 
 #define FW_VER_MAJOR 0
 #define FW_VER_MINOR 73
@@ -79,6 +92,26 @@ si5351_dev si_dev = {.i2cm_base = I2C_OPENCORES_0_BASE,
 
 #define SI_PCLK_PIN SI_CLK4
 
+#ifndef OUTPUT_VRR_DEFAULT
+#define OUTPUT_VRR_DEFAULT 0
+#endif
+
+#ifndef OUTPUT_HOLD_DEFAULT
+#define OUTPUT_HOLD_DEFAULT 1
+#endif
+
+// HDMI game mode signalling flags (HDMI_GAME_*): ALLM in HF-VSIF and AVI content type Game
+#ifndef HDMI_GAME_MODE_DEFAULT
+#define HDMI_GAME_MODE_DEFAULT (HDMI_GAME_ALLM|HDMI_GAME_CN)
+#endif
+
+#ifndef LM_PREFETCH_DIST_DEFAULT
+#define LM_PREFETCH_DIST_DEFAULT 2
+#endif
+
+// Minimum extra front porch lines so that input SOF always arrives within output vblank
+#define VRR_MARGIN_LINES 4
+
 #ifdef INC_ADV7513
 adv7513_dev advtx_dev = {.i2cm_base = I2C_OPENCORES_1_BASE,
                          .main_base = ADV7513_MAIN_BASE,
@@ -100,7 +133,7 @@ sii1136_dev siitx_dev = {
 us2066_dev chardisp_dev = {.i2cm_base = I2C_OPENCORES_0_BASE,
                            .i2c_addr = US2066_BASE};
 
-flash_ctrl_dev flashctrl_dev = {.regs = (volatile gen_flash_if_regs*)INTEL_GENERIC_SERIAL_FLASH_INTERFACE_TOP_0_AVL_CSR_BASE,
+flash_ctrl_dev flashctrl_dev = {.regs = HAL_MMIO_PTR(gen_flash_if_regs, INTEL_GENERIC_SERIAL_FLASH_INTERFACE_TOP_0_AVL_CSR_BASE),
 #ifdef C5G
                                 .flash_size = 0x2000000};
 #else
@@ -111,8 +144,8 @@ flash_ctrl_dev flashctrl_dev = {.regs = (volatile gen_flash_if_regs*)INTEL_GENER
 alt_up_character_lcd_dev charlcd_dev = {.base = CHARACTER_LCD_0_BASE};
 #endif
 
-volatile sc_regs *sc = (volatile sc_regs*)SC_CONFIG_0_BASE;
-volatile osd_regs *osd = (volatile osd_regs*)OSD_GENERATOR_0_BASE;
+volatile sc_regs *sc = HAL_MMIO_PTR(sc_regs, SC_CONFIG_0_BASE);
+volatile osd_regs *osd = HAL_MMIO_PTR(osd_regs, OSD_GENERATOR_0_BASE);
 
 struct mmc *mmc_dev;
 struct mmc * ocsdc_mmc_init(int base_addr, int clk_freq, unsigned int host_caps);
@@ -134,7 +167,76 @@ uint8_t sl_def_iv_x, sl_def_iv_y;
 
 uint8_t sd_det;
 
+// SD card presence is probed with a single sector read while mounted and with card init while absent.
+// Remount is split into separate main loop iterations so that no single iteration blocks for long.
+// Card init blocks until command timeouts without a card, so its interval doubles after each failed
+// attempt up to SD_POLL_BACKOFF_MAX times the base interval.
+#define SD_POLL_INTERVAL (1000000/MAINLOOP_INTERVAL_US)
+#define SD_POLL_BACKOFF_MAX 8
+
+typedef enum {
+    SD_STATE_ABSENT = 0,
+    SD_STATE_INIT,
+    SD_STATE_MOUNT,
+    SD_STATE_READY,
+} sd_state_t;
+
+sd_state_t sd_state;
+uint8_t sd_probe_buf[512] __attribute__((aligned(4)));
+uint8_t fb_capture_req;
+uint8_t fw_update_req;
+
+// HDMI TX interrupt (active low) routed to sys_status. HPD is polled over I2C only when it is asserted,
+// with a slow fallback poll in case interrupts are not cleared by the driver.
+#define SSTAT_HDMITX_INT_N_BIT 29
+#define HPD_POLL_INTERVAL 50
+#define I2C_STATS_INTERVAL (1000000/MAINLOOP_INTERVAL_US)
+#define I2C_BYTE_TIME_NS 22500    // 9 bit times at 400kHz
+
+// Capture path stress pattern select and VIP CVI overflow / CVO underflow event counters
+#define SCTRL_STRESS_MODE_OFFS 26
+#define SCTRL_STRESS_MODE_MASK (0x7<<SCTRL_STRESS_MODE_OFFS)
+#define SSTAT_CVI_OVERFLOW_CNT_OFFS 21
+#define SSTAT_CVO_UNDERFLOW_CNT_OFFS 13
+
+// LM line buffer prefetch distance in bursts within a line (0 = disabled), see rtl_extra/emif_sched.v
+#define SCTRL_LM_PREFETCH_OFFS 29
+#define SCTRL_LM_PREFETCH_MASK (0x7<<SCTRL_LM_PREFETCH_OFFS)
+
+// Shown frames per input frame in frame multiplication mode (0 = no BFI), see rtl_extra/bfi_sched.v
+#define SCTRL_BFI_LIT_OFFS 16
+#define SCTRL_BFI_LIT_MASK (0x3<<SCTRL_BFI_LIT_OFFS)
+
+#ifdef EMIF_PERF_MON
+// Field select for rtl_extra/emif_perf_mon.v, 13-bit result in sys_status
+#define SCTRL_EMIF_PERF_SEL_OFFS 18
+#define SCTRL_EMIF_PERF_SEL_MASK (0xf<<SCTRL_EMIF_PERF_SEL_OFFS)
+#define SSTAT_EMIF_PERF_MASK 0x1fff
+#define EMIF_PERF_SEL_SEQ 0xb
+#define EMIF_PERF_WINDOW_LOG2 24
+#define EMIF_PERF_BEAT_BYTES 32
+
+typedef struct {
+    uint32_t seq;
+    uint32_t rd_mbps;
+    uint32_t wr_mbps;
+    uint32_t rd_lat_avg_ns;
+    uint32_t rd_lat_max_ns;
+    uint32_t rd_stall_permille;
+} emif_perf_t;
+
+emif_perf_t emif_perf;
+#endif
+
 int enable_isl, enable_tp;
+uint8_t vrr_enable = OUTPUT_VRR_DEFAULT;
+uint8_t vrr_active;
+uint8_t out_hold_enable = OUTPUT_HOLD_DEFAULT;
+uint8_t hdmi_game_mode = HDMI_GAME_MODE_DEFAULT;
+uint8_t stress_mode;
+uint8_t lm_prefetch_dist = LM_PREFETCH_DIST_DEFAULT;
+uint32_t vip_cvi_overflows, vip_cvo_underflows;
+uint32_t mainloop_overruns;
 oper_mode_t oper_mode;
 
 avinput_t avinput, target_avinput;
@@ -149,14 +251,12 @@ extern char menu_row1[US2066_ROW_LEN+1], menu_row2[US2066_ROW_LEN+1];
 
 extern const char *avinput_str[];
 
-FIL file;
-char char_buff[256];
-
 #include "src/shmask_arrays.c"
 
 const shmask_data_arr* shmask_data_arr_list[] = {NULL, &shmask_agrille, &shmask_tv, &shmask_pvm, &shmask_pvm_2530, &shmask_xc_3315c, &shmask_c_1084, &shmask_jvc, &shmask_vga};
-shmask_data_arr shmask_data_arr_custom;
-shmask_data_arr *shmask_data_arr_ptr = &shmask_data_arr_custom;
+// Loaded built-in array, NULL for custom one which only lives in scratch arena during upload
+shmask_data_arr *shmask_data_arr_ptr;
+uint16_t shmask_iv_x, shmask_iv_y;
 int shmask_loaded_array = 0;
 #define SHMASKS_SIZE  (sizeof(shmask_data_arr_list) / sizeof((shmask_data_arr_list)[0]))
 
@@ -170,13 +270,25 @@ const pp_coeff* scl_pp_coeff_list[][2][2] = {{{&pp_coeff_nearest, NULL}, {&pp_co
                                             {{&pp_coeff_lanczos4, NULL}, {&pp_coeff_lanczos4, NULL}},
                                             {{&pp_coeff_gs_sharp, NULL}, {&pp_coeff_gs_sharp, NULL}}};
 int scl_loaded_pp_coeff = -1;
+scl_gen_params_t scl_gen_par;
+uint8_t scl_gen_enable;
+uint16_t scl_gen_loaded_size[4];
 #define PP_COEFF_SIZE  (sizeof(scl_pp_coeff_list) / sizeof((scl_pp_coeff_list)[0]))
 #define PP_TAPS 4
 #define PP_PHASES 64
-#define SCL_ALG_COEFF_START 3
 
 #define VIP_WDOG_VALUE 10
 
+// VIP core (consumer of monitored Avalon-ST link) indices of vip_st_monitor, see ip_extra/vip_st_monitor
+#define VIP_MON_DIL 0
+#define VIP_MON_VFB 1
+#define VIP_MON_SCL 2
+#define VIP_MON_OUT 3
+#define VIP_MON_NUM_CORES 4
+#define VIP_MON_CORE_MASK 0xf
+#define VIP_MON_RECOVERED_OFFS 8
+#define VIP_MON_STALL_LINES 4
+
 typedef struct {
     uint32_t ctrl;
     uint32_t status;
@@ -283,17 +395,132 @@ typedef struct {
     uint32_t output_rate;
 } vip_vfb_ii_regs;
 
-volatile vip_cvi_ii_regs *vip_cvi = (volatile vip_cvi_ii_regs*)ALT_VIP_CL_CVI_0_BASE;
-volatile vip_dil_ii_regs *vip_dil = (volatile vip_dil_ii_regs*)ALT_VIP_CL_DIL_0_BASE;
-volatile vip_vfb_ii_regs *vip_fb = (volatile vip_vfb_ii_regs*)ALT_VIP_CL_VFB_0_BASE;
-volatile vip_scl_ii_regs *vip_scl_pp = (volatile vip_scl_ii_regs*)ALT_VIP_CL_SCL_0_BASE;
-volatile vip_il_ii_regs *vip_il = (volatile vip_il_ii_regs*)ALT_VIP_CL_INTERLACER_0_BASE;
-volatile vip_cvo_ii_regs *vip_cvo = (volatile vip_cvo_ii_regs*)ALT_VIP_CL_CVO_0_BASE;
+typedef struct {
+    uint32_t ctrl;
+    uint32_t status;
+    uint32_t force_reset;
+    uint32_t unused;
+    uint32_t timeout_us[VIP_MON_NUM_CORES];
+    uint32_t stall_cnt[VIP_MON_NUM_CORES];
+} vip_st_mon_regs;
+
+volatile vip_cvi_ii_regs *vip_cvi = HAL_MMIO_PTR(vip_cvi_ii_regs, ALT_VIP_CL_CVI_0_BASE);
+volatile vip_dil_ii_regs *vip_dil = HAL_MMIO_PTR(vip_dil_ii_regs, ALT_VIP_CL_DIL_0_BASE);
+volatile vip_vfb_ii_regs *vip_fb = HAL_MMIO_PTR(vip_vfb_ii_regs, ALT_VIP_CL_VFB_0_BASE);
+volatile vip_scl_ii_regs *vip_scl_pp = HAL_MMIO_PTR(vip_scl_ii_regs, ALT_VIP_CL_SCL_0_BASE);
+volatile vip_il_ii_regs *vip_il = HAL_MMIO_PTR(vip_il_ii_regs, ALT_VIP_CL_INTERLACER_0_BASE);
+volatile vip_cvo_ii_regs *vip_cvo = HAL_MMIO_PTR(vip_cvo_ii_regs, ALT_VIP_CL_CVO_0_BASE);
+#ifdef VIP_ST_MONITOR_0_BASE
+volatile vip_st_mon_regs *vip_mon = HAL_MMIO_PTR(vip_st_mon_regs, VIP_ST_MONITOR_0_BASE);
+#endif
 #endif
 
 si5351_ms_config_t si_audio_mclk_48k_conf = {3740, 628, 1125, 8832, 0, 1, 0, 0, 0};
 si5351_ms_config_t si_audio_mclk_96k_conf = {3740, 628, 1125, 4160, 0, 2, 0, 0, 0};
 
+// PLLB frequency and multisynth params of the configs above
+#define SI_AUDIO_PLL_HZ 897024000ULL
+#define SI_AUDIO_PLL_MAX_HZ 900000000ULL
+#define SI_AUDIO_PLL_DENOM 1000000UL
+const uint32_t si_audio_ms_p[2][3] = {{8832, 0, 1}, {4160, 0, 2}};
+
+#ifndef AUDIO_MCLK_TRACK_DEFAULT
+#define AUDIO_MCLK_TRACK_DEFAULT 0
+#endif
+#define AUDIO_MCLK_TRIM_MAX_PPM 3000
+
+uint8_t aud_mclk_track = AUDIO_MCLK_TRACK_DEFAULT;
+uint8_t aud_mclk_96k = 1;
+uint32_t aud_trim_num = 1, aud_trim_den = 1;
+int32_t aud_trim_ppm_x10, aud_trim_err_ppb;
+
+void set_audio_mclk(uint8_t fs_96k) {
+    uint64_t pll_hz, pll_act_hz;
+    uint32_t a, b, p;
+
+    aud_mclk_96k = fs_96k;
+
+    if (aud_trim_num == aud_trim_den) {
+        aud_trim_ppm_x10 = 0;
+        aud_trim_err_ppb = 0;
+        si5351_set_frac_mult(&si_dev, SI_PLLB, SI_CLK2, SI_XTAL, 0, 0, 0, fs_96k ? &si_audio_mclk_96k_conf : &si_audio_mclk_48k_conf);
+        return;
+    }
+
+    // Scale PLLB by the same ratio that locked video clock deviates from nominal, multisynth divider is kept
+    pll_hz = (SI_AUDIO_PLL_HZ*aud_trim_num)/aud_trim_den;
+    if (pll_hz > SI_AUDIO_PLL_MAX_HZ)
+        pll_hz = SI_AUDIO_PLL_MAX_HZ;
+    a = pll_hz / si_dev.xtal_freq;
+    b = ((pll_hz % si_dev.xtal_freq) * SI_AUDIO_PLL_DENOM + si_dev.xtal_freq/2) / si_dev.xtal_freq;
+    p = (128*b) / SI_AUDIO_PLL_DENOM;
+
+    si5351_ms_config_t si_audio_mclk_trim_conf = {128*a + p - 512,
+                                                  128*b - SI_AUDIO_PLL_DENOM*p,
+                                                  SI_AUDIO_PLL_DENOM,
+                                                  si_audio_ms_p[fs_96k][0],
+                                                  si_audio_ms_p[fs_96k][1],
+                                                  si_audio_ms_p[fs_96k][2],
+                                                  0, 0, 0};
+
+    pll_act_hz = (uint64_t)si_dev.xtal_freq*a + ((uint64_t)si_dev.xtal_freq*b)/SI_AUDIO_PLL_DENOM;
+    aud_trim_ppm_x10 = (int32_t)(((int64_t)pll_act_hz - (int64_t)SI_AUDIO_PLL_HZ)*10000000LL/(int64_t)SI_AUDIO_PLL_HZ);
+    aud_trim_err_ppb = (int32_t)(((int64_t)pll_act_hz - (int64_t)((SI_AUDIO_PLL_HZ*aud_trim_num)/aud_trim_den))*1000000000LL/(int64_t)SI_AUDIO_PLL_HZ);
+
+    si5351_set_frac_mult(&si_dev, SI_PLLB, SI_CLK2, SI_XTAL, 0, 0, 0, &si_audio_mclk_trim_conf);
+}
+
+void update_audio_mclk_trim(uint32_t pclk_o_hz, uint32_t pclk_o_nom_hz) {
+    uint32_t num = 1, den = 1;
+
+    if (aud_mclk_track && (pclk_o_nom_hz > 0)) {
+        num = pclk_o_hz;
+        den = pclk_o_nom_hz;
+
+        // ignore deviations beyond trim range (e.g. output refresh differing from input)
+        if (((uint64_t)num*1000000 > (uint64_t)den*(1000000+AUDIO_MCLK_TRIM_MAX_PPM)) ||
+            ((uint64_t)num*1000000 < (uint64_t)den*(1000000-AUDIO_MCLK_TRIM_MAX_PPM)))
+            num = den = 1;
+    }
+
+    if ((num != aud_trim_num) || (den != aud_trim_den)) {
+        aud_trim_num = num;
+        aud_trim_den = den;
+        set_audio_mclk(aud_mclk_96k);
+    }
+}
+
+si_ratio_t pclk_ratio;
+uint8_t pclk_ratio_valid;
+uint32_t pclk_resync_sec;
+
+// Program locked output clock with PLL/multisynth pair found by exact ratio search instead of letting
+// driver round num/den. Returns -1 if no valid pair exists so that caller can fall back to driver.
+int set_pclk_locked(uint32_t pclk_i_hz, uint32_t ms_num, uint32_t ms_den, uint32_t h_out_hz) {
+    uint32_t pll_p[3], ms_p[3];
+
+    pclk_ratio_valid = 0;
+
+    if (si_ratio_search(pclk_i_hz, ms_num, ms_den, &pclk_ratio) != 0)
+        return -1;
+
+    si_ratio_to_p(pclk_ratio.pll_a, pclk_ratio.pll_b, pclk_ratio.pll_c, pll_p);
+    si_ratio_to_p(pclk_ratio.ms_a, pclk_ratio.ms_b, pclk_ratio.ms_c, ms_p);
+    // R divider and divide-by-4 unused (MS >= 8), CLKIN divider as assumed by ratio search
+    si5351_ms_config_t si_pclk_conf = {pll_p[0], pll_p[1], pll_p[2], ms_p[0], ms_p[1], ms_p[2], 0, 0, pclk_ratio.clkin_div};
+
+    si5351_set_frac_mult(&si_dev, SI_PLLA, SI_PCLK_PIN, SI_CLKIN, pclk_i_hz, ms_num, ms_den, &si_pclk_conf);
+
+    pclk_ratio_valid = 1;
+    pclk_resync_sec = si_ratio_resync_sec(&pclk_ratio, h_out_hz);
+
+    printf("CLKIN/%u PLL %lu+%lu/%lu MS %lu+%lu/%lu err %ldppt\n", 1<<pclk_ratio.clkin_div, pclk_ratio.pll_a, pclk_ratio.pll_b, pclk_ratio.pll_c,
+                                                                   pclk_ratio.ms_a, pclk_ratio.ms_b, pclk_ratio.ms_c, pclk_ratio.err_ppt);
+    TRACE2(PCLK_RATIO, pclk_ratio.err_ppt, pclk_resync_sec);
+
+    return 0;
+}
+
 void ui_disp_menu(uint8_t osd_mode)
 {
     uint8_t menu_page;
@@ -342,12 +569,144 @@ void ui_disp_status(uint8_t refresh_osd_timer) {
     }
 }
 
+#ifdef VIP
+// Built-in table used when a generated kernel cannot be evaluated
+#define SCL_GEN_FALLBACK_COEFF 1    // Lanczos3
+
+void vip_scl_load_pp_coeffs(int idx, int ea) {
+    int p, t;
+
+    for (p=0; p<PP_PHASES; p++) {
+        for (t=0; t<PP_TAPS; t++)
+            vip_scl_pp->coeff_data[t] = scl_pp_coeff_list[idx][0][0]->v[p][t];
+
+        vip_scl_pp->h_phase = p;
+
+        for (t=0; t<PP_TAPS; t++)
+            vip_scl_pp->coeff_data[t] = scl_pp_coeff_list[idx][1][0]->v[p][t];
+
+        vip_scl_pp->v_phase = p;
+
+        if (ea) {
+            for (t=0; t<PP_TAPS; t++)
+                vip_scl_pp->coeff_data[t] = scl_pp_coeff_list[idx][0][1]->v[p][t];
+
+            vip_scl_pp->h_phase = p+(1<<15);
+
+            for (t=0; t<PP_TAPS; t++)
+                vip_scl_pp->coeff_data[t] = scl_pp_coeff_list[idx][1][1]->v[p][t];
+
+            vip_scl_pp->v_phase = p+(1<<15);
+        }
+    }
+}
+
+// Generated set is written to both normal and edge-adaptive banks so that neither keeps a stale table
+static void vip_scl_write_gen_coeffs(const scl_gen_coeffs_t *coeffs, int vertical) {
+    int p, t, bank;
+
+    for (bank=0; bank<2; bank++) {
+        for (p=0; p<PP_PHASES; p++) {
+            for (t=0; t<PP_TAPS; t++)
+                vip_scl_pp->coeff_data[t] = coeffs->v[p][t];
+
+            if (vertical)
+                vip_scl_pp->v_phase = p+(bank<<15);
+            else
+                vip_scl_pp->h_phase = p+(bank<<15);
+        }
+    }
+}
+
+// Returns -1 if kernel parameters are invalid, in which case built-in fallback table is loaded instead
+int vip_scl_load_gen_coeffs(uint16_t h_src, uint16_t h_dst, uint16_t v_src, uint16_t v_dst) {
+    const scl_gen_coeffs_t *h_coeffs, *v_coeffs = NULL;
+
+    if ((scl_gen_loaded_size[0] == h_src) && (scl_gen_loaded_size[1] == h_dst) &&
+        (scl_gen_loaded_size[2] == v_src) && (scl_gen_loaded_size[3] == v_dst))
+        return 0;
+
+    h_coeffs = scl_gen_get_coeffs(&scl_gen_par, h_src, h_dst);
+    if (h_coeffs != NULL) {
+        vip_scl_write_gen_coeffs(h_coeffs, 0);
+
+        // fetch vertical set only after horizontal one has been written as it may evict the former from cache
+        v_coeffs = scl_gen_get_coeffs(&scl_gen_par, v_src, v_dst);
+    }
+
+    if (v_coeffs == NULL) {
+        printf("Scaler kernel %u (%u,%u) invalid for %u->%u / %u->%u, using built-in table\n", scl_gen_par.kernel, scl_gen_par.p1, scl_gen_par.p2,
+                                                                                             h_src, h_dst, v_src, v_dst);
+        vip_scl_load_pp_coeffs(SCL_GEN_FALLBACK_COEFF, 0);
+        scl_gen_enable = 0;
+        return -1;
+    }
+
+    vip_scl_write_gen_coeffs(v_coeffs, 1);
+
+    scl_gen_loaded_size[0] = h_src;
+    scl_gen_loaded_size[1] = h_dst;
+    scl_gen_loaded_size[2] = v_src;
+    scl_gen_loaded_size[3] = v_dst;
+
+    return 0;
+}
+
+#ifdef VIP_ST_MONITOR_0_BASE
+static uint32_t vip_mon_lines_to_us(mode_data_t *vm, uint32_t lines) {
+    // line period in 1/16us
+    uint32_t line_us_x16 = (1600000000UL*(vm->timings.interlaced+1)) / ((uint32_t)vm->timings.v_hz_x100*vm->timings.v_total);
+    uint32_t us = (lines*line_us_x16+15)/16;
+
+    return (us > 0xffff) ? 0xffff : us;
+}
+
+void vip_mon_set_timeouts(mode_data_t *vm_in, mode_data_t *vm_out, vm_proc_config_t *vm_conf) {
+    uint32_t out_idle_lines;
+
+    if (!vm_in->timings.v_hz_x100 || !vm_in->timings.v_total || !vm_out->timings.v_hz_x100 || !vm_out->timings.v_total) {
+        memset((void*)vip_mon->timeout_us, 0, sizeof(vip_mon->timeout_us));
+        return;
+    }
+
+    // VFB decouples input side from output timing, so DIL and VFB writer should never hold off for long
+    vip_mon->timeout_us[VIP_MON_DIL] = vip_mon_lines_to_us(vm_in, VIP_MON_STALL_LINES);
+    vip_mon->timeout_us[VIP_MON_VFB] = vip_mon_lines_to_us(vm_in, VIP_MON_STALL_LINES);
+
+    // CVO holds off during output blanking, or up to a whole frame while aligning to input in framelock
+    out_idle_lines = (vm_conf->framelock || (vm_conf->y_size >= vm_out->timings.v_total)) ? vm_out->timings.v_total : vm_out->timings.v_total-vm_conf->y_size;
+    vip_mon->timeout_us[VIP_MON_SCL] = vip_mon_lines_to_us(vm_out, out_idle_lines+VIP_MON_STALL_LINES);
+    vip_mon->timeout_us[VIP_MON_OUT] = vip_mon_lines_to_us(vm_out, out_idle_lines+VIP_MON_STALL_LINES);
+}
+#endif
+#endif
+
+// Opens SD card text file with file object and line buffer from scratch arena. Caller takes a
+// scratch mark beforehand and releases it after file_close().
+static FIL* open_text_file(const char *filename, char **line) {
+    FIL *fp;
+
+    if (!sd_det)
+        return NULL;
+
+    fp = scratch_alloc(sizeof(FIL));
+    *line = scratch_alloc(SCRATCH_LINE_LEN);
+    if (!fp || !*line || file_open(fp, filename))
+        return NULL;
+
+    return fp;
+}
+
 void update_sc_config(mode_data_t *vm_in, mode_data_t *vm_out, vm_proc_config_t *vm_conf, avconfig_t *avconfig)
 {
     int vip_enable, scl_target_pp_coeff, scl_ea, i, p, t, n;
     int v0,v1,v2,v3;
     char target_filename[16];
     uint32_t h_blank, v_blank, h_frontporch, v_frontporch;
+    shmask_data_arr *shmask_prev_ptr, *shmask_custom;
+    scratch_mark_t mark;
+    FIL *fp;
+    char *line;
 
     hv_config_reg hv_in_config = {.data=0x00000000};
     hv_config2_reg hv_in_config2 = {.data=0x00000000};
@@ -363,58 +722,79 @@ void update_sc_config(mode_data_t *vm_in, mode_data_t *vm_out, vm_proc_config_t
     sl_config2_reg sl_config2 = {.data=0x00000000};
     sl_config3_reg sl_config3 = {.data=0x00000000};
 
+    TRACE2(SC_CONFIG, vm_out->timings.h_active, vm_out->timings.v_active);
+
 #ifdef VIP
-    vip_enable = !enable_tp && (avconfig->oper_mode == 1);
+    vip_enable = !enable_tp && (avconfig->oper_mode == 1) && (oper_mode != OPERMODE_ADAPT_LM);
 #else
     vip_enable = 0;
 #endif
 
     if (avconfig->shmask_mode && (avconfig->shmask_mode != shmask_loaded_array)) {
+        // sc_config has a single live mask array (no preloaded banks), so masks are still uploaded by CPU
+        // on switch. Previously loaded built-in array describes current HW contents and allows delta update.
+        shmask_prev_ptr = ((shmask_loaded_array > 0) && (shmask_loaded_array < SHMASKS_SIZE)) ? shmask_data_arr_ptr : NULL;
+
+        mark = scratch_mark();
+
         if (avconfig->shmask_mode >= SHMASKS_SIZE) { // Custom
-            sniprintf(target_filename, sizeof(target_filename), "shmask%d.txt", (avconfig->shmask_mode + 1 - SHMASKS_SIZE) );
-            if (!file_open(&file, target_filename)) {
-                i = 0;
-                while (file_get_string(&file, char_buff, sizeof(char_buff))) {
-                    if (char_buff[0] == '#')
-                        continue;
-                    if (!i && (bscanf(char_buff, "%d,%d", &v0, &v1) == 2)) {
-                        shmask_data_arr_custom.iv_x = v0-1;
-                        shmask_data_arr_custom.iv_y = v1-1;
-                        i = 1;
-                    } else if (i && (v1 > 0)) {
-                        p = shmask_data_arr_custom.iv_y+1-v1;
-                        if (bscanf(char_buff, "%hx,%hx,%hx,%hx,%hx,%hx,%hx,%hx,%hx,%hx,%hx,%hx,%hx,%hx,%hx,%hx", &shmask_data_arr_custom.v[p][0],
-                                                                                                                 &shmask_data_arr_custom.v[p][1],
-                                                                                                                 &shmask_data_arr_custom.v[p][2],
-                                                                                                                 &shmask_data_arr_custom.v[p][3],
-                                                                                                                 &shmask_data_arr_custom.v[p][4],
-                                                                                                                 &shmask_data_arr_custom.v[p][5],
-                                                                                                                 &shmask_data_arr_custom.v[p][6],
-                                                                                                                 &shmask_data_arr_custom.v[p][7],
-                                                                                                                 &shmask_data_arr_custom.v[p][8],
-                                                                                                                 &shmask_data_arr_custom.v[p][9],
-                                                                                                                 &shmask_data_arr_custom.v[p][10],
-                                                                                                                 &shmask_data_arr_custom.v[p][11],
-                                                                                                                 &shmask_data_arr_custom.v[p][12],
-                                                                                                                 &shmask_data_arr_custom.v[p][13],
-                                                                                                                 &shmask_data_arr_custom.v[p][14],
-                                                                                                                 &shmask_data_arr_custom.v[p][15]) == v0)
-                            v1--;
+            shmask_custom = scratch_alloc(sizeof(shmask_data_arr));
+            if (shmask_custom) {
+                memset(shmask_custom, 0, sizeof(shmask_data_arr));
+                sniprintf(target_filename, sizeof(target_filename), "shmask%d.txt", (avconfig->shmask_mode + 1 - SHMASKS_SIZE) );
+                if ((fp = open_text_file(target_filename, &line)) != NULL) {
+                    i = 0;
+                    while (file_get_string(fp, line, SCRATCH_LINE_LEN)) {
+                        if (line[0] == '#')
+                            continue;
+                        if (!i && (bscanf(line, "%d,%d", &v0, &v1) == 2)) {
+                            shmask_custom->iv_x = v0-1;
+                            shmask_custom->iv_y = v1-1;
+                            i = 1;
+                        } else if (i && (v1 > 0)) {
+                            p = shmask_custom->iv_y+1-v1;
+                            if (bscanf(line, "%hx,%hx,%hx,%hx,%hx,%hx,%hx,%hx,%hx,%hx,%hx,%hx,%hx,%hx,%hx,%hx", &shmask_custom->v[p][0],
+                                                                                                                &shmask_custom->v[p][1],
+                                                                                                                &shmask_custom->v[p][2],
+                                                                                                                &shmask_custom->v[p][3],
+                                                                                                                &shmask_custom->v[p][4],
+                                                                                                                &shmask_custom->v[p][5],
+                                                                                                                &shmask_custom->v[p][6],
+                                                                                                                &shmask_custom->v[p][7],
+                                                                                                                &shmask_custom->v[p][8],
+                                                                                                                &shmask_custom->v[p][9],
+                                                                                                                &shmask_custom->v[p][10],
+                                                                                                                &shmask_custom->v[p][11],
+                                                                                                                &shmask_custom->v[p][12],
+                                                                                                                &shmask_custom->v[p][13],
+                                                                                                                &shmask_custom->v[p][14],
+                                                                                                                &shmask_custom->v[p][15]) == v0)
+                                v1--;
+                        }
                     }
+                    file_close(fp);
                 }
-                file_close(&file);
             }
-
-            shmask_data_arr_ptr = &shmask_data_arr_custom;
+            shmask_data_arr_ptr = shmask_custom;
         } else {
             shmask_data_arr_ptr = (shmask_data_arr*)shmask_data_arr_list[avconfig->shmask_mode];
         }
 
-        for (p=0; p<=shmask_data_arr_ptr->iv_y; p++) {
-            for (t=0; t<=shmask_data_arr_ptr->iv_x; t++)
-                sc->shmask_data_array.data[p][t] = shmask_data_arr_ptr->v[p][t];
+        if (shmask_data_arr_ptr) {
+            for (p=0; p<=shmask_data_arr_ptr->iv_y; p++) {
+                for (t=0; t<=shmask_data_arr_ptr->iv_x; t++) {
+                    if (!shmask_prev_ptr || (p > shmask_prev_ptr->iv_y) || (t > shmask_prev_ptr->iv_x) || (shmask_prev_ptr->v[p][t] != shmask_data_arr_ptr->v[p][t]))
+                        sc->shmask_data_array.data[p][t] = shmask_data_arr_ptr->v[p][t];
+                }
+            }
+            shmask_iv_x = shmask_data_arr_ptr->iv_x;
+            shmask_iv_y = shmask_data_arr_ptr->iv_y;
         }
 
+        if (avconfig->shmask_mode >= SHMASKS_SIZE)
+            shmask_data_arr_ptr = NULL;
+        scratch_release(mark);
+
         shmask_loaded_array = avconfig->shmask_mode;
     }
 
@@ -458,11 +838,12 @@ void update_sc_config(mode_data_t *vm_in, mode_data_t *vm_out, vm_proc_config_t
     misc_config.nir_even_offset = avconfig->nir_even_offset;
     misc_config.ypbpr_cs = (avconfig->ypbpr_cs == 0) ? ((vm_in->type & VIDEO_HDTV) ? 1 : 0) : avconfig->ypbpr_cs-1;
     misc_config.vip_enable = vip_enable;
-    misc_config.bfi_enable = avconfig->bfi_enable & ((uint32_t)vm_out->timings.v_hz_x100*5 >= (uint32_t)vm_in->timings.v_hz_x100*9);
+    // frame multiplication modes get BFI from bfi_sched instead
+    misc_config.bfi_enable = !frame_mult_active && avconfig->bfi_enable & ((uint32_t)vm_out->timings.v_hz_x100*5 >= (uint32_t)vm_in->timings.v_hz_x100*9);
     misc_config.bfi_str = avconfig->bfi_str;
     misc_config.shmask_enable = (avconfig->shmask_mode != 0);
-    misc_config.shmask_iv_x = shmask_data_arr_ptr->iv_x;
-    misc_config.shmask_iv_y = shmask_data_arr_ptr->iv_y;
+    misc_config.shmask_iv_x = shmask_iv_x;
+    misc_config.shmask_iv_y = shmask_iv_y;
 
     // set default/custom scanline interval
     sl_def_iv_y = (vm_conf->y_rpt > 0) ? vm_conf->y_rpt : 1;
@@ -536,6 +917,10 @@ void update_sc_config(mode_data_t *vm_in, mode_data_t *vm_out, vm_proc_config_t
     sc->sl_config3 = sl_config3;
 
 #ifdef VIP
+#ifdef VIP_ST_MONITOR_0_BASE
+    // automatic resets are re-enabled by vip_wdog_update() once cores run with new config
+    vip_mon->ctrl = 0;
+#endif
     vip_cvi->ctrl = vip_enable;
     vip_dil->ctrl = vip_enable;
     vip_il->ctrl = vip_enable;
@@ -557,6 +942,10 @@ void update_sc_config(mode_data_t *vm_in, mode_data_t *vm_out, vm_proc_config_t
         return;
     }
 
+#ifdef VIP_ST_MONITOR_0_BASE
+    vip_mon_set_timeouts(vm_in, vm_out, vm_conf);
+#endif
+
 #ifndef VIP_DIL_B
     if (avconfig->scl_dil_alg == 0) {
         vip_dil->mode = (1<<1);
@@ -578,13 +967,24 @@ void update_sc_config(mode_data_t *vm_in, mode_data_t *vm_out, vm_proc_config_t
     vip_il->config = !vm_out->timings.interlaced;
 
     if (scl_target_pp_coeff != scl_loaded_pp_coeff) {
+        scl_gen_enable = 0;
+        memset(scl_gen_loaded_size, 0, sizeof(scl_gen_loaded_size));
+
         if (scl_target_pp_coeff >= PP_COEFF_SIZE) { // Custom
             snprintf(target_filename, sizeof(target_filename), "scaler%d.txt", (scl_target_pp_coeff + 1 - PP_COEFF_SIZE) );
-            if (!file_open(&file, target_filename)) {
+            mark = scratch_mark();
+            if ((fp = open_text_file(target_filename, &line)) != NULL) {
                 p = 0;
-                while (file_get_string(&file, char_buff, sizeof(char_buff))) {
-                    n = bscanf(char_buff, "%d,%d,%d,%d", &v0, &v1, &v2, &v3);
-                    if (n == PP_TAPS) {
+                while (file_get_string(fp, line, SCRATCH_LINE_LEN)) {
+                    n = bscanf(line, "%d,%d,%d,%d", &v0, &v1, &v2, &v3);
+                    if ((p == 0) && (n == 3)) {
+                        // Parametric kernel header (kernel,p1,p2) instead of coefficient table
+                        scl_gen_par.kernel = v0;
+                        scl_gen_par.p1 = v1;
+                        scl_gen_par.p2 = v2;
+                        scl_gen_enable = 1;
+                        break;
+                    } else if (n == PP_TAPS) {
                         vip_scl_pp->coeff_data[0] = v0;
                         vip_scl_pp->coeff_data[1] = v1;
                         vip_scl_pp->coeff_data[2] = v2;
@@ -597,37 +997,19 @@ void update_sc_config(mode_data_t *vm_in, mode_data_t *vm_out, vm_proc_config_t
                             break;
                     }
                 }
-                file_close(&file);
+                file_close(fp);
             }
+            scratch_release(mark);
         } else {
-            for (p=0; p<PP_PHASES; p++) {
-                for (t=0; t<PP_TAPS; t++)
-                    vip_scl_pp->coeff_data[t] = scl_pp_coeff_list[scl_target_pp_coeff][0][0]->v[p][t];
-
-                vip_scl_pp->h_phase = p;
-
-                for (t=0; t<PP_TAPS; t++)
-                    vip_scl_pp->coeff_data[t] = scl_pp_coeff_list[scl_target_pp_coeff][1][0]->v[p][t];
-
-                vip_scl_pp->v_phase = p;
-
-                if (scl_ea) {
-                    for (t=0; t<PP_TAPS; t++)
-                        vip_scl_pp->coeff_data[t] = scl_pp_coeff_list[scl_target_pp_coeff][0][1]->v[p][t];
-
-                    vip_scl_pp->h_phase = p+(1<<15);
-
-                    for (t=0; t<PP_TAPS; t++)
-                        vip_scl_pp->coeff_data[t] = scl_pp_coeff_list[scl_target_pp_coeff][1][1]->v[p][t];
-
-                    vip_scl_pp->v_phase = p+(1<<15);
-                }
-            }
+            vip_scl_load_pp_coeffs(scl_target_pp_coeff, scl_ea);
         }
 
         scl_loaded_pp_coeff = scl_target_pp_coeff;
     }
 
+    if (scl_gen_enable)
+        vip_scl_load_gen_coeffs(vm_in->timings.h_active, vm_conf->x_size, vm_in->timings.v_active<<vm_in->timings.interlaced, vm_conf->y_size<<vm_out->timings.interlaced);
+
     vip_scl_pp->edge_thold = avconfig->scl_edge_thold;
 
     vip_scl_pp->width = vm_conf->x_size;
@@ -681,16 +1063,22 @@ void update_sc_config(mode_data_t *vm_in, mode_data_t *vm_out, vm_proc_config_t
 void vip_dil_hard_reset() {
     // Hard-reset VIP DIL which occasionally gets stuck
     sys_ctrl &= ~SCTRL_VIP_DIL_RESET_N;
-    IOWR_ALTERA_AVALON_PIO_DATA(PIO_0_BASE, sys_ctrl);
-    usleep(10);
+    hal_pio_wr(PIO_0_BASE, sys_ctrl);
+    hal_usleep(10);
 
     sys_ctrl |= SCTRL_VIP_DIL_RESET_N;
-    IOWR_ALTERA_AVALON_PIO_DATA(PIO_0_BASE, sys_ctrl);
+    hal_pio_wr(PIO_0_BASE, sys_ctrl);
 }
 
 int vip_wdog_update() {
     static uint8_t vip_wdog_ctr = 0;
     static uint32_t vip_frame_cnt_prev = 0;
+    static uint32_t vip_wdog_resets = 0;
+#ifdef VIP_ST_MONITOR_0_BASE
+    static uint32_t vip_mon_pending = 0;
+    uint32_t recovered;
+    int i;
+#endif
 
     // CVI producing data, input stable and valid resolution
     const uint32_t cvi_status_mask = (1<<0)|(1<<8)|(1<<10);
@@ -705,39 +1093,146 @@ int vip_wdog_update() {
 
     vip_frame_cnt_prev = vip_frame_cnt;
 
+#ifdef VIP_ST_MONITOR_0_BASE
+    // Stalled cores get reset and flushed by vip_st_monitor within a few lines. Their registers have been
+    // restored by update_sc_config() after previous call, so automatic reset of them can be re-armed.
+    if (vip_mon_pending) {
+        vip_mon->status = vip_mon_pending << VIP_MON_RECOVERED_OFFS;
+        vip_mon_pending = 0;
+    }
+    vip_mon->ctrl = ((vip_cvi->status & cvi_status_mask) == cvi_status_mask) ? VIP_MON_CORE_MASK : 0;
+
+    recovered = (vip_mon->status >> VIP_MON_RECOVERED_OFFS) & VIP_MON_CORE_MASK;
+    if (recovered) {
+        printf("VIP stall recovery 0x%lx:", recovered);
+        for (i=0; i<VIP_MON_NUM_CORES; i++)
+            printf(" %lu", vip_mon->stall_cnt[i]);
+        printf("\n");
+        TRACE2(VIP_STALL, recovered, (vip_mon->stall_cnt[VIP_MON_DIL] & 0xff) | ((vip_mon->stall_cnt[VIP_MON_VFB] & 0xff) << 8) |
+                                     ((vip_mon->stall_cnt[VIP_MON_SCL] & 0xff) << 16) | ((vip_mon->stall_cnt[VIP_MON_OUT] & 0xff) << 24));
+        // reset cleared scaler coefficient memory
+        if (recovered & (1<<VIP_MON_SCL))
+            scl_loaded_pp_coeff = -1;
+        vip_mon_pending = recovered;
+        vip_wdog_ctr = 0;
+        return 1;
+    }
+#endif
+
     if (vip_wdog_ctr >= VIP_WDOG_VALUE) {
+        TRACE1(VIP_WDOG_RESET, ++vip_wdog_resets);
+#ifdef VIP_ST_MONITOR_0_BASE
+        // fallback for DIL hangs which do not show up as a link stall
+        vip_mon->force_reset = (1<<VIP_MON_DIL);
+        vip_mon_pending = (1<<VIP_MON_DIL);
+#else
         vip_dil_hard_reset();
+#endif
         vip_wdog_ctr = 0;
         return 1;
     }
 
     return 0;
 }
+
+#ifdef FB_CAPTURE_DDR_WINDOW
+// VFB II register map has no write buffer pointer, and with drop/repeat the writer does not rotate
+// buffers in order. Capture relies on restart resetting buffer management so that the first frame
+// written afterwards goes to buffer 0. This is not documented by Intel; see "Frame capture" in
+// README.md for the hardware check. Capture is refused unless exactly one frame was written, so that
+// a second frame cannot have moved the writer on to another buffer.
+#define VFB_CAPTURE_BUFFER      0
+#define VFB_CAPTURE_TIMEOUT_US  200000
+
+static int vip_wait_idle(volatile uint32_t *status, uint32_t timeout_us) {
+    hal_timestamp_t end_ts = hal_timestamp() + hal_us_to_ticks(timeout_us);
+
+    while (*status & 1) {
+        if (hal_timestamp() >= end_ts)
+            return -1;
+    }
+
+    return 0;
+}
+
+int vip_capture_frame(uint16_t width, uint16_t height) {
+    hal_timestamp_t end_ts;
+    uint32_t frame_cnt;
+    int ret = FB_CAPTURE_NOT_AVAIL;
+
+    if (!vip_fb->ctrl)
+        return FB_CAPTURE_NOT_AVAIL;
+
+    // Halt input and VFB at frame boundary
+    vip_cvi->ctrl = 0;
+    vip_fb->ctrl = 0;
+    if ((vip_wait_idle(&vip_cvi->status, VFB_CAPTURE_TIMEOUT_US) != 0) || (vip_wait_idle(&vip_fb->status, VFB_CAPTURE_TIMEOUT_US) != 0))
+        goto resume;
+
+    // Let exactly one input frame into restarted VFB, then freeze it again. The frame is complete once
+    // counter advances, and buffer 0 is not written again before the next restart as input is halted
+    // before a third frame could start.
+    frame_cnt = vip_fb->frame_cnt;
+    vip_fb->ctrl = 1;
+    vip_cvi->ctrl = 1;
+    end_ts = hal_timestamp() + hal_us_to_ticks(VFB_CAPTURE_TIMEOUT_US);
+    while ((vip_fb->frame_cnt == frame_cnt) && (hal_timestamp() < end_ts)) {}
+    vip_cvi->ctrl = 0;
+    vip_fb->ctrl = 0;
+
+    // buffer 0 holds no valid frame if none arrived in time
+    if ((vip_wait_idle(&vip_fb->status, VFB_CAPTURE_TIMEOUT_US) == 0) && (vip_fb->frame_cnt == frame_cnt+1))
+        ret = fb_capture_write(width, height, VFB_CAPTURE_BUFFER, vip_fb->frame_cnt, row2, US2066_ROW_LEN+1);
+    else
+        printf("FB capture: %lu frames written after restart\n", vip_fb->frame_cnt-frame_cnt);
+
+resume:
+    vip_fb->ctrl = 1;
+    vip_cvi->ctrl = 1;
+
+    return ret;
+}
+#endif
+#endif
+
+#ifdef FW_UPDATE_BOARD_ID
+static uint8_t fw_update_pct;
+
+void fw_update_progress(uint32_t done, uint32_t total) {
+    uint8_t pct = ((uint64_t)done*100)/total;
+
+    // character display is behind I2C, so refresh only when shown value changes
+    if (pct != fw_update_pct) {
+        sniprintf(row2, US2066_ROW_LEN+1, "%u%%", pct);
+        ui_disp_status(1);
+        fw_update_pct = pct;
+    }
+}
 #endif
 
 int init_emif()
 {
-    alt_timestamp_type start_ts;
+    hal_timestamp_t start_ts;
 
     sys_ctrl |= SCTRL_EMIF_HWRESET_N;
-    IOWR_ALTERA_AVALON_PIO_DATA(PIO_0_BASE, sys_ctrl);
-    start_ts = alt_timestamp();
+    hal_pio_wr(PIO_0_BASE, sys_ctrl);
+    start_ts = hal_timestamp();
     while (1) {
-        sys_status = IORD_ALTERA_AVALON_PIO_DATA(PIO_2_BASE);
+        sys_status = hal_pio_rd(PIO_2_BASE);
         if (sys_status & (1<<SSTAT_EMIF_PLL_LOCKED))
             break;
-        else if (alt_timestamp() >= start_ts + 100000*(TIMER_0_FREQ/1000000))
+        else if (hal_timestamp() >= start_ts + hal_us_to_ticks(100000))
             return -1;
     }
 
     sys_ctrl |= SCTRL_EMIF_SWRESET_N;
-    IOWR_ALTERA_AVALON_PIO_DATA(PIO_0_BASE, sys_ctrl);
-    start_ts = alt_timestamp();
+    hal_pio_wr(PIO_0_BASE, sys_ctrl);
+    start_ts = hal_timestamp();
     while (1) {
-        sys_status = IORD_ALTERA_AVALON_PIO_DATA(PIO_2_BASE);
+        sys_status = hal_pio_rd(PIO_2_BASE);
         if (sys_status & (1<<SSTAT_EMIF_STAT_INIT_DONE_BIT))
             break;
-        else if (alt_timestamp() >= start_ts + 100000*(TIMER_0_FREQ/1000000))
+        else if (hal_timestamp() >= start_ts + hal_us_to_ticks(100000))
             return -2;
     }
     if (((sys_status & SSTAT_EMIF_STAT_MASK) >> SSTAT_EMIF_STAT_OFFS) != 0x3) {
@@ -747,13 +1242,13 @@ int init_emif()
 
     // Place LPDDR2 into deep powerdown mode
     sys_ctrl |= (SCTRL_EMIF_POWERDN_REQ);
-    IOWR_ALTERA_AVALON_PIO_DATA(PIO_0_BASE, sys_ctrl);
-    start_ts = alt_timestamp();
+    hal_pio_wr(PIO_0_BASE, sys_ctrl);
+    start_ts = hal_timestamp();
     while (1) {
-        sys_status = IORD_ALTERA_AVALON_PIO_DATA(PIO_2_BASE);
+        sys_status = hal_pio_rd(PIO_2_BASE);
         if (sys_status & (1<<SSTAT_EMIF_POWERDN_ACK_BIT))
             break;
-        else if (alt_timestamp() >= start_ts + 100000*(TIMER_0_FREQ/1000000))
+        else if (hal_timestamp() >= start_ts + hal_us_to_ticks(100000))
             return -4;
     }
 
@@ -789,6 +1284,7 @@ int init_sdcard() {
         printf("Bus Width: %d-bit\n\n", mmc_dev->bus_width);
 
         sd_det = 1;
+        sd_state = SD_STATE_READY;
         res = file_mount(); // check result when confident the SD detection is robust enough
 
         /*char buff[256];
@@ -802,20 +1298,98 @@ int init_sdcard() {
     return 0;
 }
 
+#ifdef DE10N
+// Settings reside on SD card. Without a card fail immediately instead of waiting for MMC timeouts.
+// Profile load/save from menu fails fast as well since the volume is unmounted whenever sd_det is clear.
+int read_userdata_sd_det(uint8_t entry, int dry_run) {
+    return sd_det ? read_userdata_sd(entry, dry_run) : -1;
+}
+#endif
+
+// Returns 1 when card has been (re)mounted and file-backed config should be reloaded
+int sd_hotplug_update() {
+    static uint16_t sd_poll_ctr;
+    static uint8_t sd_poll_backoff = 1;
+    sd_state_t sd_state_prev = sd_state;
+    int ret = 0;
+
+    switch (sd_state) {
+    case SD_STATE_ABSENT:
+        if (++sd_poll_ctr >= sd_poll_backoff*SD_POLL_INTERVAL) {
+            sd_poll_ctr = 0;
+            sd_state = SD_STATE_INIT;
+        }
+        break;
+    case SD_STATE_INIT:
+        mmc_dev->has_init = 0;
+        if ((mmc_init(mmc_dev) == 0) && mmc_dev->has_init) {
+            sd_state = SD_STATE_MOUNT;
+        } else {
+            if (sd_poll_backoff < SD_POLL_BACKOFF_MAX)
+                sd_poll_backoff *= 2;
+            sd_state = SD_STATE_ABSENT;
+        }
+        break;
+    case SD_STATE_MOUNT:
+        if (file_mount() == FR_OK) {
+            printf("SD card mounted\n");
+            sd_det = 1;
+            sd_state = SD_STATE_READY;
+            sd_poll_backoff = 1;
+
+#ifdef DE10N
+            // card holds settings, so load them as on boot
+            read_userdata_sd_det(SD_INIT_CONFIG_SLOT, 0);
+            read_userdata_sd_det(0, 0);
+#endif
+
+            // retry custom files which may have been skipped while card was absent
+            if (shmask_loaded_array >= SHMASKS_SIZE)
+                shmask_loaded_array = 0;
+            if (scl_loaded_pp_coeff >= PP_COEFF_SIZE)
+                scl_loaded_pp_coeff = -1;
+            ret = 1;
+        } else {
+            // drop registered volume so that FatFs does not retry mount on next file access
+            f_unmount("");
+            sd_state = SD_STATE_ABSENT;
+        }
+        break;
+    case SD_STATE_READY:
+        if (++sd_poll_ctr >= SD_POLL_INTERVAL) {
+            sd_poll_ctr = 0;
+            if (disk_read(0, sd_probe_buf, 0, 1) != RES_OK) {
+                // volume stays unmounted while card is absent so that any other file access fails fast
+                printf("SD card removed\n");
+                sd_det = 0;
+                f_unmount("");
+                sd_poll_backoff = 1;
+                sd_state = SD_STATE_ABSENT;
+            }
+        }
+        break;
+    }
+
+    if (sd_state != sd_state_prev)
+        TRACE1(SD_STATE, sd_state);
+
+    return ret;
+}
+
 int init_hw() {
     int ret;
 
     // reset hw
     sys_ctrl = 0x00;
-    IOWR_ALTERA_AVALON_PIO_DATA(PIO_0_BASE, sys_ctrl);
-    usleep(400000);
+    hal_pio_wr(PIO_0_BASE, sys_ctrl);
+    hal_usleep(400000);
     sys_ctrl |= SCTRL_EMIF_MPFE_RESET_N|SCTRL_VIP_DIL_RESET_N;
-    IOWR_ALTERA_AVALON_PIO_DATA(PIO_0_BASE, sys_ctrl);
+    hal_pio_wr(PIO_0_BASE, sys_ctrl);
 
-    I2C_init(I2C_OPENCORES_0_BASE,ALT_CPU_FREQ,400000);
-    I2C_init(I2C_OPENCORES_1_BASE,ALT_CPU_FREQ,400000);
+    hal_i2c_init(I2C_OPENCORES_0_BASE, 400000);
+    hal_i2c_init(I2C_OPENCORES_1_BASE, 400000);
 #ifdef C5G
-    I2C_init(I2C_OPENCORES_2_BASE,ALT_CPU_FREQ,400000);
+    hal_i2c_init(I2C_OPENCORES_2_BASE, 400000);
 #endif
 
     // Init character OLED
@@ -840,8 +1414,8 @@ int init_hw() {
 #endif
 #ifdef INC_SII1136
     sys_ctrl |= SCTRL_HDMI_RESET_N;
-    IOWR_ALTERA_AVALON_PIO_DATA(PIO_0_BASE, sys_ctrl);
-    usleep(20000);
+    hal_pio_wr(PIO_0_BASE, sys_ctrl);
+    hal_usleep(20000);
     ret = sii1136_init(&siitx_dev);
     if (ret != 0) {
         sniprintf(row1, US2066_ROW_LEN+1, "SII1136 init fail");
@@ -860,14 +1434,14 @@ int init_hw() {
 
     // Enable test pattern generation
     sys_ctrl |= SCTRL_VGTP_ENABLE;
-    IOWR_ALTERA_AVALON_PIO_DATA(PIO_0_BASE, sys_ctrl);
+    hal_pio_wr(PIO_0_BASE, sys_ctrl);
 
     // Init Si5351C
     sniprintf(row1, US2066_ROW_LEN+1, "Init Si5351C");
     ui_disp_status(1);
     si5351_init(&si_dev);
 
-    si5351_set_frac_mult(&si_dev, SI_PLLB, SI_CLK2, SI_XTAL, 0, 0, 0, &si_audio_mclk_96k_conf);
+    set_audio_mclk(1);
 
     //init ocsdc driver
     mmc_dev = ocsdc_mmc_init(SDC_CONTROLLER_0_BASE, SDC_FREQ, SDC_HOST_CAPS);
@@ -876,13 +1450,8 @@ int init_hw() {
     mmc_dev->f_max = SDC_FREQ / 4;
 #endif
     mmc_dev->has_init = 0;
-    ret = init_sdcard();
-#ifdef DE10N
-    if (ret != 0) {
-        sniprintf(row1, US2066_ROW_LEN+1, "SD init fail");
-        return ret;
-    }
-#endif
+    // card may be inserted later, sd_hotplug_update() takes care of mounting
+    init_sdcard();
 
     set_default_profile(1);
     set_default_settings();
@@ -890,8 +1459,8 @@ int init_hw() {
 
     // Load initconfig and profile
 #ifdef DE10N
-    read_userdata_sd(SD_INIT_CONFIG_SLOT, 0);
-    read_userdata_sd(0, 0);
+    read_userdata_sd_det(SD_INIT_CONFIG_SLOT, 0);
+    read_userdata_sd_det(0, 0);
 #else
     read_userdata(INIT_CONFIG_SLOT, 0);
     read_userdata(0, 0);
@@ -936,6 +1505,67 @@ void sys_toggle_power() {
     return;
 }
 
+#ifdef EMIF_PERF_MON
+static uint32_t emif_perf_rd(uint8_t sel) {
+    sys_ctrl = (sys_ctrl & ~SCTRL_EMIF_PERF_SEL_MASK) | ((uint32_t)sel << SCTRL_EMIF_PERF_SEL_OFFS);
+    hal_pio_wr(PIO_0_BASE, sys_ctrl);
+    // select is synchronized to EMIF clock and result registered
+    hal_usleep(1);
+    return hal_pio_rd(PIO_2_BASE) & SSTAT_EMIF_PERF_MASK;
+}
+
+static uint32_t emif_perf_rd26(uint8_t sel) {
+    return emif_perf_rd(sel) | (emif_perf_rd(sel+1) << 13);
+}
+
+// Reads the latest completed measurement window. Returns 1 if it was not seen before.
+int emif_perf_update() {
+    uint32_t seq, rd_beats, wr_beats, lat_sum, lat_cnt, rd_stall, lat_max;
+
+    // retry if window ended in the middle of readout
+    do {
+        seq = emif_perf_rd(EMIF_PERF_SEL_SEQ);
+        rd_beats = emif_perf_rd26(0x0);
+        wr_beats = emif_perf_rd26(0x2);
+        lat_sum = emif_perf_rd26(0x4);
+        lat_cnt = emif_perf_rd26(0x6);
+        rd_stall = emif_perf_rd26(0x8);
+        lat_max = emif_perf_rd(0xa);
+    } while (seq != emif_perf_rd(EMIF_PERF_SEL_SEQ));
+
+    if (seq == emif_perf.seq)
+        return 0;
+
+    emif_perf.seq = seq;
+    emif_perf.rd_mbps = ((uint64_t)rd_beats*EMIF_PERF_BEAT_BYTES*EMIF_PERF_CLK_MHZ) >> EMIF_PERF_WINDOW_LOG2;
+    emif_perf.wr_mbps = ((uint64_t)wr_beats*EMIF_PERF_BEAT_BYTES*EMIF_PERF_CLK_MHZ) >> EMIF_PERF_WINDOW_LOG2;
+    emif_perf.rd_lat_avg_ns = lat_cnt ? ((uint64_t)lat_sum*1000)/((uint64_t)lat_cnt*EMIF_PERF_CLK_MHZ) : 0;
+    emif_perf.rd_lat_max_ns = (lat_max*1000)/EMIF_PERF_CLK_MHZ;
+    emif_perf.rd_stall_permille = ((uint64_t)rd_stall*1000) >> EMIF_PERF_WINDOW_LOG2;
+
+    return 1;
+}
+#endif
+
+void update_vip_err_counters(uint32_t status, uint8_t reset) {
+    static uint8_t cvi_overflow_cnt_prev, cvo_underflow_cnt_prev;
+    uint8_t cvi_overflow_cnt = (status >> SSTAT_CVI_OVERFLOW_CNT_OFFS) & 0xff;
+    uint8_t cvo_underflow_cnt = (status >> SSTAT_CVO_UNDERFLOW_CNT_OFFS) & 0xff;
+
+    if (reset) {
+        vip_cvi_overflows = 0;
+        vip_cvo_underflows = 0;
+    } else {
+        if ((cvi_overflow_cnt != cvi_overflow_cnt_prev) || (cvo_underflow_cnt != cvo_underflow_cnt_prev))
+            TRACE2(VIP_ERR, (uint8_t)(cvi_overflow_cnt - cvi_overflow_cnt_prev), (uint8_t)(cvo_underflow_cnt - cvo_underflow_cnt_prev));
+        vip_cvi_overflows += (uint8_t)(cvi_overflow_cnt - cvi_overflow_cnt_prev);
+        vip_cvo_underflows += (uint8_t)(cvo_underflow_cnt - cvo_underflow_cnt_prev);
+    }
+
+    cvi_overflow_cnt_prev = cvi_overflow_cnt;
+    cvo_underflow_cnt_prev = cvo_underflow_cnt;
+}
+
 void print_vm_stats() {
     int row = 0;
     memset((void*)osd->osd_array.data, 0, sizeof(osd_char_array));
@@ -961,7 +1591,7 @@ void print_vm_stats() {
         sniprintf((char*)osd->osd_array.data[row][0], OSD_CHAR_COLS, "Output mode:");
         sniprintf((char*)osd->osd_array.data[row][1], OSD_CHAR_COLS, "%s", vmode_out.name);
         sniprintf((char*)osd->osd_array.data[++row][0], OSD_CHAR_COLS, "Refresh rate:");
-        sniprintf((char*)osd->osd_array.data[row][1], OSD_CHAR_COLS, "%u.%.2uHz (%s)", vmode_out.timings.v_hz_x100/100, vmode_out.timings.v_hz_x100%100, vm_conf.framelock ? "lock" : "unlock");
+        sniprintf((char*)osd->osd_array.data[row][1], OSD_CHAR_COLS, "%u.%.2uHz (%s)", vmode_out.timings.v_hz_x100/100, vmode_out.timings.v_hz_x100%100, vm_conf.framelock ? "lock" : (vrr_active ? "vrr" : "unlock"));
         sniprintf((char*)osd->osd_array.data[++row][0], OSD_CHAR_COLS, "H/V synclen:");
         sniprintf((char*)osd->osd_array.data[row][1], OSD_CHAR_COLS, "%.5u %.5u", vmode_out.timings.h_synclen, vmode_out.timings.v_synclen);
         sniprintf((char*)osd->osd_array.data[++row][0], OSD_CHAR_COLS, "H/V backporch:");
@@ -970,8 +1600,51 @@ void print_vm_stats() {
         sniprintf((char*)osd->osd_array.data[row][1], OSD_CHAR_COLS, "%.5u %.5u", vmode_out.timings.h_active, vmode_out.timings.v_active);
         sniprintf((char*)osd->osd_array.data[++row][0], OSD_CHAR_COLS, "H/V total:");
         sniprintf((char*)osd->osd_array.data[row][1], OSD_CHAR_COLS, "%.5u %.5u", vmode_out.timings.h_total, vmode_out.timings.v_total);
+        if (aud_mclk_track) {
+            sniprintf((char*)osd->osd_array.data[++row][0], OSD_CHAR_COLS, "Audio MCLK trim:");
+            sniprintf((char*)osd->osd_array.data[row][1], OSD_CHAR_COLS, "%c%ld.%.1ldppm (err %ldppb)", (aud_trim_ppm_x10 < 0) ? '-' : '+',
+                                                                                                       labs(aud_trim_ppm_x10)/10,
+                                                                                                       labs(aud_trim_ppm_x10)%10,
+                                                                                                       aud_trim_err_ppb);
+        }
+        if (vm_conf.framelock && pclk_ratio_valid) {
+            sniprintf((char*)osd->osd_array.data[++row][0], OSD_CHAR_COLS, "Clock error:");
+            if (pclk_ratio.exact)
+                sniprintf((char*)osd->osd_array.data[row][1], OSD_CHAR_COLS, "exact");
+            else
+                sniprintf((char*)osd->osd_array.data[row][1], OSD_CHAR_COLS, "%c%lu.%.6luppm", (pclk_ratio.err_ppt < 0) ? '-' : '+',
+                                                                                            labs(pclk_ratio.err_ppt)/1000000,
+                                                                                            labs(pclk_ratio.err_ppt)%1000000);
+            sniprintf((char*)osd->osd_array.data[++row][0], OSD_CHAR_COLS, "Resync every:");
+            if (pclk_resync_sec == 0xffffffff)
+                sniprintf((char*)osd->osd_array.data[row][1], OSD_CHAR_COLS, "never");
+            else if (pclk_resync_sec >= 3600)
+                sniprintf((char*)osd->osd_array.data[row][1], OSD_CHAR_COLS, "~%luh %.2lumin", pclk_resync_sec/3600, (pclk_resync_sec/60)%60);
+            else
+                sniprintf((char*)osd->osd_array.data[row][1], OSD_CHAR_COLS, "~%lumin %.2lus", pclk_resync_sec/60, pclk_resync_sec%60);
+        }
         row++;
     }
+#ifdef VIP
+    sniprintf((char*)osd->osd_array.data[++row][0], OSD_CHAR_COLS, "VIP ovf/udf:");
+    sniprintf((char*)osd->osd_array.data[row][1], OSD_CHAR_COLS, "%lu / %lu%s", vip_cvi_overflows, vip_cvo_underflows, stress_mode ? " (stress)" : "");
+#ifdef VIP_ST_MONITOR_0_BASE
+    sniprintf((char*)osd->osd_array.data[++row][0], OSD_CHAR_COLS, "VIP stall D/F/S/O:");
+    sniprintf((char*)osd->osd_array.data[row][1], OSD_CHAR_COLS, "%lu/%lu/%lu/%lu", vip_mon->stall_cnt[VIP_MON_DIL], vip_mon->stall_cnt[VIP_MON_VFB],
+                                                                                   vip_mon->stall_cnt[VIP_MON_SCL], vip_mon->stall_cnt[VIP_MON_OUT]);
+#endif
+#endif
+#ifdef EMIF_PERF_MON
+    sniprintf((char*)osd->osd_array.data[++row][0], OSD_CHAR_COLS, "LM DDR rd/wr:");
+    sniprintf((char*)osd->osd_array.data[row][1], OSD_CHAR_COLS, "%lu/%luMB/s lat %lu/%luns", emif_perf.rd_mbps, emif_perf.wr_mbps,
+                                                                                             emif_perf.rd_lat_avg_ns, emif_perf.rd_lat_max_ns);
+#endif
+    sniprintf((char*)osd->osd_array.data[++row][0], OSD_CHAR_COLS, "I2C load:");
+    sniprintf((char*)osd->osd_array.data[row][1], OSD_CHAR_COLS, "%luB/s (%lu.%.1lu%%)", i2c_bytes_per_period,
+                                                                                        (i2c_bytes_per_period*I2C_BYTE_TIME_NS)/10000000,
+                                                                                        ((i2c_bytes_per_period*I2C_BYTE_TIME_NS)/1000000)%10);
+    sniprintf((char*)osd->osd_array.data[++row][0], OSD_CHAR_COLS, "Scratch peak:");
+    sniprintf((char*)osd->osd_array.data[row][1], OSD_CHAR_COLS, "%lu / %luB", scratch_peak(), scratch_size());
     sniprintf((char*)osd->osd_array.data[++row][0], OSD_CHAR_COLS, "Firmware:");
     sniprintf((char*)osd->osd_array.data[row][1], OSD_CHAR_COLS, "v%u.%.2u @ " __DATE__, FW_VER_MAJOR, FW_VER_MINOR);
     osd->osd_config.status_refresh = 1;
@@ -1037,11 +1710,313 @@ void update_settings(int init_setup) {
     memcpy(&cs, &ts, sizeof(settings_t));
 }
 
+// Output clock and TX setup applied on previous mode change
+typedef struct {
+    uint8_t valid;
+    si5351_clk_src clk_src;
+    int8_t si_pclk_mult;
+    uint32_t pclk_i_hz;
+    uint32_t ms_num;
+    uint32_t ms_den;
+    mode_data_t vm_out;
+} out_setup_t;
+
+out_setup_t out_setup;
+
+// Returns 1 if output clock and TX can be left running as-is for new setup. Output timing generator then
+// never stops, and scanconverter attaches to the relocked input at its next frame start.
+static int out_setup_unchanged(out_setup_t *prev, out_setup_t *next) {
+    uint32_t pclk_i_diff;
+
+    if (!out_hold_enable || !prev->valid)
+        return 0;
+
+    if ((prev->clk_src != next->clk_src) || (prev->si_pclk_mult != next->si_pclk_mult) ||
+        ((uint64_t)prev->ms_num*next->ms_den != (uint64_t)next->ms_num*prev->ms_den))
+        return 0;
+
+    // locked clock follows input, so it must stay within PLL pull range of the old one
+    if (next->clk_src == SI_CLKIN) {
+        pclk_i_diff = (next->pclk_i_hz > prev->pclk_i_hz) ? next->pclk_i_hz - prev->pclk_i_hz : prev->pclk_i_hz - next->pclk_i_hz;
+        if (pclk_i_diff > prev->pclk_i_hz/256)
+            return 0;
+    }
+
+    return !memcmp(&prev->vm_out.timings, &next->vm_out.timings, sizeof(next->vm_out.timings)) &&
+           (prev->vm_out.tx_pixelrep == next->vm_out.tx_pixelrep) &&
+           (prev->vm_out.hdmitx_pixr_ifr == next->vm_out.hdmitx_pixr_ifr) &&
+           (prev->vm_out.vic == next->vm_out.vic);
+}
+
+#ifdef INC_ADV7513
+// ADV7513 main map AVI InfoFrame fields / packet enables and spare packet 1 slot in packet memory map
+#define ADV_MAIN_PKT_ENABLE     0x40
+#define ADV_PKT_ENABLE_SPARE1   (1<<0)
+#define ADV_MAIN_PKT_UPDATE     0x4a
+#define ADV_PKT_UPDATE_AVI      (1<<6)
+#define ADV_MAIN_AVI_PB3        0x57
+#define ADV_MAIN_AVI_PB5        0x59
+#define ADV_PKTMEM_SPARE1       0xc0
+#define ADV_PKTMEM_SPARE1_UPD   0xdf
+#define ADV_PKTMEM_UPD_HOLD     (1<<7)
+
+// Last hdmi_game_mode written to TX, invalidated whenever the driver rewrites AVI/packet setup
+uint8_t hdmi_game_applied = 0xff;
+
+static void adv_writereg(adv7513_dev *dev, uint8_t i2c_addr, uint8_t regaddr, uint8_t data) {
+    I2C_start(dev->i2cm_base, i2c_addr, 0);
+    I2C_write(dev->i2cm_base, regaddr, 0);
+    I2C_write(dev->i2cm_base, data, 1);
+}
+
+static uint8_t adv_readreg(adv7513_dev *dev, uint8_t i2c_addr, uint8_t regaddr) {
+    I2C_start(dev->i2cm_base, i2c_addr, 0);
+    I2C_write(dev->i2cm_base, regaddr, 0);
+    I2C_start(dev->i2cm_base, i2c_addr, 1);
+    return I2C_read(dev->i2cm_base, 1);
+}
+
+// HF-VSIF is sent from spare packet 1 with checksum from hdmi_pkt. ITC/CN are merged into the AVI
+// InfoFrame fields set by the driver; the chip computes AVI checksum itself.
+static void adv7513_set_game_mode(adv7513_dev *dev, uint8_t mode) {
+    hdmi_infoframe_t pkt;
+    uint8_t pkt_en, upd;
+    int i;
+
+    pkt_en = adv_readreg(dev, dev->main_base, ADV_MAIN_PKT_ENABLE);
+    if (mode & HDMI_GAME_ALLM) {
+        hdmi_pkt_hf_vsif(&pkt, 1);
+        adv_writereg(dev, dev->pktmem_base, ADV_PKTMEM_SPARE1_UPD, ADV_PKTMEM_UPD_HOLD);
+        for (i=0; i<HDMI_IF_HB_LEN; i++)
+            adv_writereg(dev, dev->pktmem_base, ADV_PKTMEM_SPARE1+i, pkt.hb[i]);
+        for (i=0; i<HDMI_IF_PB_LEN; i++)
+            adv_writereg(dev, dev->pktmem_base, ADV_PKTMEM_SPARE1+HDMI_IF_HB_LEN+i, pkt.pb[i]);
+        adv_writereg(dev, dev->pktmem_base, ADV_PKTMEM_SPARE1_UPD, 0);
+        pkt_en |= ADV_PKT_ENABLE_SPARE1;
+    } else {
+        pkt_en &= ~ADV_PKT_ENABLE_SPARE1;
+    }
+    adv_writereg(dev, dev->main_base, ADV_MAIN_PKT_ENABLE, pkt_en);
+
+    memset(&pkt, 0, sizeof(pkt));
+    pkt.hb[0] = HDMI_IF_TYPE_AVI;
+    pkt.hb[1] = HDMI_AVI_VERSION;
+    pkt.hb[2] = HDMI_AVI_LEN;
+    pkt.pb[3] = adv_readreg(dev, dev->main_base, ADV_MAIN_AVI_PB3);
+    pkt.pb[5] = adv_readreg(dev, dev->main_base, ADV_MAIN_AVI_PB5);
+    hdmi_pkt_avi_set_content_type(&pkt, !!(mode & HDMI_GAME_CN), (mode & HDMI_GAME_CN) ? HDMI_CN_GAME : HDMI_CN_GRAPHICS);
+
+    upd = adv_readreg(dev, dev->main_base, ADV_MAIN_PKT_UPDATE);
+    adv_writereg(dev, dev->main_base, ADV_MAIN_PKT_UPDATE, upd | ADV_PKT_UPDATE_AVI);
+    adv_writereg(dev, dev->main_base, ADV_MAIN_AVI_PB3, pkt.pb[3]);
+    adv_writereg(dev, dev->main_base, ADV_MAIN_AVI_PB5, pkt.pb[5]);
+    adv_writereg(dev, dev->main_base, ADV_MAIN_PKT_UPDATE, upd & ~ADV_PKT_UPDATE_AVI);
+}
+#endif
+
+#ifdef HOST_CMD_ENABLE
+// Runtime variables reachable via HOST_CMD_SET_VAR/GET_VAR, indexed by host_var_id_t
+static uint8_t* const host_vars[HOST_NUM_VARS] = {&stress_mode, &fb_capture_req, &vrr_enable, &aud_mclk_track, &lm_prefetch_dist, &fw_update_req, &out_hold_enable, &hdmi_game_mode};
+static const uint8_t host_var_max[HOST_NUM_VARS] = {7, 1, 1, 1, 7, 1, 1, 2, 3};
+
+// Custom scaler/shadow mask slots (scalerN.txt / shmaskN.txt) selectable over host interface
+#define HOST_AVC_CUSTOM_FILES 9
+
+typedef struct {
+    uint16_t offs;
+    uint8_t size;
+    uint16_t max;
+} host_avc_field_t;
+
+#define HOST_AVC_FIELD(f, m) {offsetof(avconfig_t, f), sizeof(((avconfig_t*)0)->f), (m)}
+
+// avconfig fields writable with HOST_CMD_WR_AVCONFIG and their largest valid value. Writes touching any
+// other byte are rejected, e.g. tp_mode which is used as standard mode table index without bounds check.
+static const host_avc_field_t host_avc_fields[] = {
+    HOST_AVC_FIELD(oper_mode, 1),
+    HOST_AVC_FIELD(lm_mode, 1),
+    HOST_AVC_FIELD(lm_deint_mode, 1),
+    HOST_AVC_FIELD(pm_240p, 5),
+    HOST_AVC_FIELD(pm_384p, 5),
+    HOST_AVC_FIELD(pm_480i, 5),
+    HOST_AVC_FIELD(pm_480p, 5),
+    HOST_AVC_FIELD(pm_1080i, 5),
+    HOST_AVC_FIELD(pm_ad_240p, 5),
+    HOST_AVC_FIELD(pm_ad_288p, 5),
+    HOST_AVC_FIELD(pm_ad_384p, 5),
+    HOST_AVC_FIELD(pm_ad_480i, 5),
+    HOST_AVC_FIELD(pm_ad_576i, 5),
+    HOST_AVC_FIELD(pm_ad_480p, 5),
+    HOST_AVC_FIELD(pm_ad_576p, 5),
+    HOST_AVC_FIELD(scl_out_mode, 15),
+    HOST_AVC_FIELD(scl_alg, SCL_ALG_COEFF_START+PP_COEFF_SIZE-1+HOST_AVC_CUSTOM_FILES),
+    HOST_AVC_FIELD(scl_dil_alg, 3),
+    HOST_AVC_FIELD(scl_edge_thold, 255),
+    HOST_AVC_FIELD(sl_mode, 2),
+    HOST_AVC_FIELD(sl_type, 3),
+    HOST_AVC_FIELD(sl_method, 1),
+    HOST_AVC_FIELD(sl_altern, 1),
+    HOST_AVC_FIELD(sl_id, 1),
+    HOST_AVC_FIELD(shmask_mode, SHMASKS_SIZE-1+HOST_AVC_CUSTOM_FILES),
+    HOST_AVC_FIELD(bfi_enable, 1),
+    HOST_AVC_FIELD(ypbpr_cs, 2),
+};
+
+// Range must consist of whole whitelisted fields whose new (little-endian) values are within limits
+static int host_avconfig_write_ok(uint16_t offs, const uint8_t *data, uint8_t len) {
+    const host_avc_field_t *f;
+    uint32_t val;
+    uint16_t pos = offs;
+    int i, b;
+
+    while (pos < offs+len) {
+        f = NULL;
+        for (i=0; i<sizeof(host_avc_fields)/sizeof(host_avc_fields[0]); i++) {
+            if (host_avc_fields[i].offs == pos) {
+                f = &host_avc_fields[i];
+                break;
+            }
+        }
+        if (!f || (pos+f->size > offs+len))
+            return 0;
+
+        val = 0;
+        for (b=0; b<f->size; b++)
+            val |= (uint32_t)data[pos-offs+b] << (8*b);
+        if (val > f->max)
+            return 0;
+
+        pos += f->size;
+    }
+
+    return 1;
+}
+
+static host_cmd_health_t host_health;
+
+static const void* host_obj(uint8_t obj, uint32_t *size) {
+    switch (obj) {
+    case HOST_OBJ_VMODE_IN:
+        *size = sizeof(vmode_in);
+        return &vmode_in;
+    case HOST_OBJ_VMODE_OUT:
+        *size = sizeof(vmode_out);
+        return &vmode_out;
+    case HOST_OBJ_VM_CONF:
+        *size = sizeof(vm_conf);
+        return &vm_conf;
+    case HOST_OBJ_AVCONFIG:
+        *size = sizeof(avconfig_t);
+        return get_current_avconfig();
+    case HOST_OBJ_HEALTH:
+        host_health.timestamp = (uint32_t)hal_timestamp();
+        host_health.vip_cvi_overflows = vip_cvi_overflows;
+        host_health.vip_cvo_underflows = vip_cvo_underflows;
+        host_health.mainloop_overruns = mainloop_overruns;
+        host_health.trace_lost = trace_lost_records();
+        host_health.cmd_frames = host_cmd_get_stats()->frames;
+        host_health.cmd_errors = host_cmd_get_stats()->errors;
+        host_health.avinput = avinput;
+        host_health.sync_active = enable_tp || (enable_isl && isl_dev.sync_active);
+        host_health.oper_mode = oper_mode;
+        host_health.framelock = vm_conf.framelock;
+        *size = sizeof(host_health);
+        return &host_health;
+#ifdef EMIF_PERF_MON
+    case HOST_OBJ_EMIF_PERF:
+        *size = sizeof(emif_perf);
+        return &emif_perf;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+// Runs a host command within main loop. Changes take effect through the same paths as menu and
+// remote actions (target avconfig, target_avinput, request flags) on this or next iteration.
+static void host_cmd_exec(const host_cmd_t *cmd) {
+    const uint8_t *p = cmd->payload;
+    const uint8_t *obj;
+    uint32_t size, offs, val, w[2];
+    int ret;
+
+    switch (cmd->id) {
+    case HOST_CMD_PING:
+        host_cmd_reply(cmd, HOST_CMD_OK, (FW_VER_MAJOR << 8) | FW_VER_MINOR, HAL_TIMESTAMP_FREQ, (uint32_t)hal_timestamp());
+        break;
+    case HOST_CMD_SET_INPUT:
+        if ((cmd->len != 1) || (p[0] > AV1_RGBCS)) {
+            host_cmd_reply(cmd, HOST_CMD_ERR_ARG, 0, 0, 0);
+            break;
+        }
+        target_avinput = p[0];
+        host_cmd_reply(cmd, HOST_CMD_OK, 0, 0, 0);
+        break;
+    case HOST_CMD_LOAD_PROFILE:
+        if (cmd->len != 1) {
+            host_cmd_reply(cmd, HOST_CMD_ERR_ARG, 0, 0, 0);
+            break;
+        }
+#ifdef DE10N
+        ret = read_userdata_sd_det(p[0], 0);
+#else
+        ret = read_userdata(p[0], 0);
+#endif
+        host_cmd_reply(cmd, (ret == 0) ? HOST_CMD_OK : HOST_CMD_ERR_FAIL, ret, 0, 0);
+        break;
+    case HOST_CMD_WR_AVCONFIG:
+        offs = p[0] | (p[1] << 8);
+        if ((cmd->len < 3) || (cmd->len > 14) || (offs + cmd->len-2 > sizeof(avconfig_t)) || !host_avconfig_write_ok(offs, p+2, cmd->len-2)) {
+            host_cmd_reply(cmd, HOST_CMD_ERR_ARG, 0, 0, 0);
+            break;
+        }
+        memcpy((uint8_t*)get_target_avconfig() + offs, p+2, cmd->len-2);
+        host_cmd_reply(cmd, HOST_CMD_OK, 0, 0, 0);
+        break;
+    case HOST_CMD_RD_OBJ:
+        obj = (cmd->len == 3) ? host_obj(p[0], &size) : NULL;
+        offs = 4*(p[1] | (p[2] << 8));
+        if (!obj || (offs >= size)) {
+            host_cmd_reply(cmd, HOST_CMD_ERR_ARG, 0, 0, 0);
+            break;
+        }
+        w[0] = w[1] = 0;
+        memcpy(w, obj+offs, ((size-offs) < sizeof(w)) ? size-offs : sizeof(w));
+        host_cmd_reply(cmd, HOST_CMD_OK, size, w[0], w[1]);
+        break;
+    case HOST_CMD_SET_VAR:
+        val = p[1] | (p[2] << 8) | ((uint32_t)p[3] << 16) | ((uint32_t)p[4] << 24);
+        if ((cmd->len != 5) || (p[0] >= HOST_NUM_VARS) || (val > host_var_max[p[0]])) {
+            host_cmd_reply(cmd, HOST_CMD_ERR_ARG, 0, 0, 0);
+            break;
+        }
+        *host_vars[p[0]] = val;
+        host_cmd_reply(cmd, HOST_CMD_OK, 0, 0, 0);
+        break;
+    case HOST_CMD_GET_VAR:
+        if ((cmd->len != 1) || (p[0] >= HOST_NUM_VARS)) {
+            host_cmd_reply(cmd, HOST_CMD_ERR_ARG, 0, 0, 0);
+            break;
+        }
+        host_cmd_reply(cmd, HOST_CMD_OK, *host_vars[p[0]], 0, 0);
+        break;
+    case HOST_CMD_RELOCK:
+        avinput = (avinput_t)-1;
+        host_cmd_reply(cmd, HOST_CMD_OK, 0, 0, 0);
+        break;
+    default:
+        host_cmd_reply(cmd, HOST_CMD_ERR_CMD, 0, 0, 0);
+        break;
+    }
+}
+#endif
+
 void mainloop()
 {
-    int i, man_input_change, setup_rc_ret, setup_rc_flag=0;
+    int i, man_input_change, setup_rc_ret, setup_rc_flag=0, isl_cfg_force=1, out_hold;
+    uint8_t hpd_poll_ctr=0, i2c_stats_ctr=0, advtx_powered_on_prev=0;
     char op_status[4];
-    uint32_t pclk_i_hz, pclk_o_hz, dotclk_hz, h_hz, pll_h_total, pll_h_total_prev=0;
+    uint32_t pclk_i_hz, pclk_o_hz, dotclk_hz, h_hz, pll_h_total, pll_h_total_prev=0, v_total_vrr, pclk_lock_hz, pclk_nom_hz;
     uint8_t h_skip_prev, sampler_phase_prev;
     isl_input_t target_isl_input=0;
     video_sync target_isl_sync=0;
@@ -1049,24 +2024,57 @@ void mainloop()
     status_t status;
     avconfig_t *cur_avconfig, *tgt_avconfig;
     si5351_clk_src si_clk_src;
-    alt_timestamp_type start_ts;
+    out_setup_t out_setup_next;
+    hal_timestamp_t start_ts;
+    int fb_capture_ret;
+#ifdef FW_UPDATE_BOARD_ID
+    int fw_update_ret;
+    fw_update_stats_t fw_update_stats;
+#endif
+#ifdef CTRL_EVENT_FIFO_0_BASE
+    uint32_t ctrl_word;
+#endif
+#ifdef HOST_CMD_ENABLE
+    host_cmd_t host_cmd;
+#endif
 
     cur_avconfig = get_current_avconfig();
     tgt_avconfig = get_target_avconfig();
 
     // remote setup
-    if ((~IORD_ALTERA_AVALON_PIO_DATA(PIO_1_BASE) >> CONTROLS_BTN_OFFS) & JOY_DOWN) {
+    if ((~hal_pio_rd(PIO_1_BASE) >> CONTROLS_BTN_OFFS) & JOY_DOWN) {
         target_avinput = AV_TESTPAT;
         setup_rc_flag = 1;
     }
 
+#ifdef FW_UPDATE_BOARD_ID
+    // flash update from SD card
+    if ((~hal_pio_rd(PIO_1_BASE) >> CONTROLS_BTN_OFFS) & JOY_UP)
+        fw_update_req = 1;
+#endif
+
     while (1) {
-        start_ts = alt_timestamp();
+        start_ts = hal_timestamp();
 
+#ifdef CTRL_EVENT_FIFO_0_BASE
+        // replay all events captured since last iteration before regular controls update
+        while (ctrl_events_next(&ctrl_word)) {
+            ctrl_events_replay(ctrl_word);
+            read_controls();
+            if (!setup_rc_flag)
+                parse_control();
+        }
+        ctrl_events_replay(ctrl_events_last());
+#endif
         read_controls();
         if (!setup_rc_flag)
             parse_control();
 
+#ifdef HOST_CMD_ENABLE
+        while (host_cmd_poll(&host_cmd))
+            host_cmd_exec(&host_cmd);
+#endif
+
         if (!sys_powered_on)
             break;
 
@@ -1111,8 +2119,10 @@ void mainloop()
             }
 
             printf("### SWITCH MODE TO %s ###\n", avinput_str[target_avinput]);
+            TRACE1(INPUT_SWITCH, target_avinput);
 
             avinput = target_avinput;
+            isl_cfg_force = 1;
             isl_enable_power(&isl_dev, 0);
             isl_enable_outputs(&isl_dev, 0);
 
@@ -1137,7 +2147,7 @@ void mainloop()
                 sys_ctrl |= SCTRL_VGTP_ENABLE;
             }
 
-            IOWR_ALTERA_AVALON_PIO_DATA(PIO_0_BASE, sys_ctrl);
+            hal_pio_wr(PIO_0_BASE, sys_ctrl);
 
             if (!enable_tp) {
                 strlcpy(row1, avinput_str[avinput], US2066_ROW_LEN+1);
@@ -1152,6 +2162,9 @@ void mainloop()
         if (enable_tp) {
             if (status & TP_MODE_CHANGE) {
                 get_standard_mode(cur_avconfig->tp_mode, &vmode_in, &vmode_out, &vm_conf);
+                vrr_active = 0;
+                out_setup.valid = 0;
+                pclk_ratio_valid = 0;
 
                 pclk_o_hz = calculate_pclk(si_dev.xtal_freq, &vmode_out, &vm_conf);
                 printf("PCLK_OUT: %luHz\n", pclk_o_hz);
@@ -1165,6 +2178,7 @@ void mainloop()
                 update_sc_config(&vmode_in, &vmode_out, &vm_conf, cur_avconfig);
 #ifdef INC_ADV7513
                 adv7513_set_pixelrep_vic(&advtx_dev, vmode_out.tx_pixelrep, vmode_out.hdmitx_pixr_ifr, vmode_out.vic);
+                hdmi_game_applied = 0xff;
 #endif
 #ifdef INC_SII1136
                 sii1136_init_mode(&siitx_dev, vmode_out.tx_pixelrep, vmode_out.hdmitx_pixr_ifr, vmode_out.vic, pclk_o_hz);
@@ -1183,6 +2197,7 @@ void mainloop()
                     isl_enable_power(&isl_dev, 1);
                     isl_enable_outputs(&isl_dev, 1);
                     printf("ISL51002 sync up\n");
+                    TRACE0(SYNC_UP);
                 } else {
                     isl_enable_power(&isl_dev, 0);
                     isl_enable_outputs(&isl_dev, 0);
@@ -1190,6 +2205,7 @@ void mainloop()
                     strlcpy(row2, "    NO SYNC", US2066_ROW_LEN+1);
                     ui_disp_status(1);
                     printf("ISL51002 sync lost\n");
+                    TRACE0(SYNC_LOST);
                 }
             }
 
@@ -1219,6 +2235,8 @@ void mainloop()
                     vmode_in.timings.interlaced = isl_dev.ss.interlace_flag;
 
                     oper_mode = get_operating_mode(cur_avconfig, &vmode_in, &vmode_out, &vm_conf);
+                    oper_mode = int_scale_select(cur_avconfig, oper_mode, &vmode_in, &vmode_out, &vm_conf);
+                    oper_mode = frame_mult_select(oper_mode, &vmode_in, &vmode_out, &vm_conf);
 
                     if (oper_mode == OPERMODE_PURE_LM)
                         sniprintf(op_status, 4, "x%u", vm_conf.y_rpt+1);
@@ -1251,6 +2269,24 @@ void mainloop()
                         printf("H: %lu.%.2lukHz V: %u.%.2uHz\n", (h_hz+5)/1000, ((h_hz+5)%1000)/10, (vmode_in.timings.v_hz_x100/100), (vmode_in.timings.v_hz_x100%100));
                         printf("Estimated source dot clock: %lu.%.2luMHz\n", (dotclk_hz+5000)/1000000, ((dotclk_hz+5000)%1000000)/10000);
                         printf("PCLK_IN: %luHz PCLK_OUT: %luHz\n", pclk_i_hz, pclk_o_hz);
+                        TRACE4(MODE_CHANGE, vmode_in.timings.v_total, vmode_in.timings.interlaced, oper_mode, pclk_o_hz);
+
+                        // Variable refresh: free-running output clock, but frame is restarted by scanconverter framelock
+                        // logic at each input SOF. Output v_total is stretched to outlast input frame period so that
+                        // the restart always happens in front porch and effectively shortens it per frame.
+                        // Not applicable when input is faster than nominal output rate, as restarts would then cut into
+                        // the active area of unstretched output frame.
+                        vrr_active = vrr_enable && !vm_conf.framelock && (oper_mode != OPERMODE_SCALER) && !vmode_out.timings.interlaced &&
+                                     (vmode_in.timings.v_hz_x100 > 0) && (vmode_in.timings.v_hz_x100 <= vmode_out.timings.v_hz_x100);
+                        if (vrr_active) {
+                            v_total_vrr = ((pclk_o_hz/vmode_out.timings.h_total)*100)/vmode_in.timings.v_hz_x100 + VRR_MARGIN_LINES;
+                            if (v_total_vrr > vmode_out.timings.v_total) {
+                                vmode_out.timings.v_total = v_total_vrr;
+                                // refresh rate of stretched frame without restarts, i.e. slowest rate the sink will see
+                                vmode_out.timings.v_hz_x100 = ((uint64_t)pclk_o_hz*100)/((uint32_t)vmode_out.timings.h_total*v_total_vrr);
+                            }
+                            printf("VRR v_total: %u (%u.%.2uHz)\n", vmode_out.timings.v_total, vmode_out.timings.v_hz_x100/100, vmode_out.timings.v_hz_x100%100);
+                        }
 
                         // CEA-770.3 HDTV modes use tri-level syncs which have twice the width of bi-level syncs of corresponding CEA-861 modes
                         if ((vmode_in.type & VIDEO_HDTV) && (target_isl_sync == SYNC_SOG)) {
@@ -1261,6 +2297,7 @@ void mainloop()
                         }
 
                         isl_source_setup(&isl_dev, pll_h_total);
+                        isl_cfg_force = 1;
 
                         isl_set_afe_bw(&isl_dev, dotclk_hz);
 
@@ -1269,20 +2306,42 @@ void mainloop()
 
                         pll_h_total_prev = pll_h_total;
 
-                        // Setup Si5351
-                        if (vm_conf.si_pclk_mult == 0)
-                            si5351_set_frac_mult(&si_dev,
-                                                 SI_PLLA,
-                                                 SI_PCLK_PIN,
-                                                 si_clk_src,
-                                                 pclk_i_hz,
-                                                 vm_conf.framelock ? vmode_out.timings.h_total*vmode_out.timings.v_total*(vmode_in.timings.interlaced+1)*vm_conf.framelock : pclk_o_hz/1000,
-                                                 vm_conf.framelock ? pll_h_total*vmode_in.timings.v_total*(vmode_out.timings.interlaced+1) : si_dev.xtal_freq/1000,
-                                                 NULL);
-                        else
-                            si5351_set_integer_mult(&si_dev, SI_PLLA, SI_PCLK_PIN, si_clk_src, pclk_i_hz, (vm_conf.si_pclk_mult > 0) ? vm_conf.si_pclk_mult : 1, (vm_conf.si_pclk_mult < 0) ? (-1)*vm_conf.si_pclk_mult : 0);
+                        out_setup_next.valid = 1;
+                        out_setup_next.clk_src = si_clk_src;
+                        out_setup_next.si_pclk_mult = vm_conf.si_pclk_mult;
+                        out_setup_next.pclk_i_hz = pclk_i_hz;
+                        out_setup_next.ms_num = vm_conf.framelock ? vmode_out.timings.h_total*vmode_out.timings.v_total*(vmode_in.timings.interlaced+1)*vm_conf.framelock : pclk_o_hz/1000;
+                        out_setup_next.ms_den = vm_conf.framelock ? pll_h_total*vmode_in.timings.v_total*(vmode_out.timings.interlaced+1) : si_dev.xtal_freq/1000;
+                        memcpy(&out_setup_next.vm_out, &vmode_out, sizeof(mode_data_t));
+                        out_hold = out_setup_unchanged(&out_setup, &out_setup_next);
+                        memcpy(&out_setup, &out_setup_next, sizeof(out_setup_t));
+
+                        if (out_hold) {
+                            // Reprogramming output clock or TX would make the sink resync even with identical settings
+                            printf("Output held\n");
+                            TRACE1(OUT_HOLD, pclk_o_hz);
+                        } else {
+                            // Setup Si5351
+                            pclk_ratio_valid = 0;
+                            if (vm_conf.si_pclk_mult == 0) {
+                                if (!vm_conf.framelock || (set_pclk_locked(pclk_i_hz, out_setup.ms_num, out_setup.ms_den, pclk_o_hz/vmode_out.timings.h_total) != 0))
+                                    si5351_set_frac_mult(&si_dev, SI_PLLA, SI_PCLK_PIN, si_clk_src, pclk_i_hz, out_setup.ms_num, out_setup.ms_den, NULL);
+                            } else {
+                                si5351_set_integer_mult(&si_dev, SI_PLLA, SI_PCLK_PIN, si_clk_src, pclk_i_hz, (vm_conf.si_pclk_mult > 0) ? vm_conf.si_pclk_mult : 1, (vm_conf.si_pclk_mult < 0) ? (-1)*vm_conf.si_pclk_mult : 0);
+                            }
+
+                            // Retrim audio MCLK to follow locked video clock, i.e. by how much the programmed input-derived
+                            // clock deviates from nominal pixel clock of output mode
+                            if (vm_conf.framelock) {
+                                pclk_lock_hz = (vm_conf.si_pclk_mult == 0) ? ((uint64_t)pclk_i_hz*out_setup.ms_num)/out_setup.ms_den : pclk_o_hz;
+                                pclk_nom_hz = ((uint64_t)vmode_out.timings.h_total*vmode_out.timings.v_total*vmode_out.timings.v_hz_x100)/(100*(vmode_out.timings.interlaced+1));
+                                update_audio_mclk_trim(pclk_lock_hz, pclk_nom_hz);
+                            } else {
+                                update_audio_mclk_trim(pclk_o_hz, 0);
+                            }
+                        }
 
-                        if (vm_conf.framelock)
+                        if (vm_conf.framelock || vrr_active)
                             sys_ctrl |= SCTRL_FRAMELOCK;
                         else
                             sys_ctrl &= ~SCTRL_FRAMELOCK;
@@ -1293,18 +2352,21 @@ void mainloop()
                             sys_ctrl |= SCTRL_ISL_HS_POL;
                         if ((target_isl_sync == SYNC_HV) && isl_dev.ss.v_polarity)
                             sys_ctrl |= SCTRL_ISL_VS_POL;
-                        IOWR_ALTERA_AVALON_PIO_DATA(PIO_0_BASE, sys_ctrl);
+                        hal_pio_wr(PIO_0_BASE, sys_ctrl);
 
                         update_osd_size(&vmode_out);
                         update_sc_config(&vmode_in, &vmode_out, &vm_conf, cur_avconfig);
 
                         // Setup VIC and pixel repetition
+                        if (!out_hold) {
 #ifdef INC_ADV7513
-                        adv7513_set_pixelrep_vic(&advtx_dev, vmode_out.tx_pixelrep, vmode_out.hdmitx_pixr_ifr, vmode_out.vic);
+                            adv7513_set_pixelrep_vic(&advtx_dev, vmode_out.tx_pixelrep, vmode_out.hdmitx_pixr_ifr, vmode_out.vic);
+                            hdmi_game_applied = 0xff;
 #endif
 #ifdef INC_SII1136
-                        sii1136_init_mode(&siitx_dev, vmode_out.tx_pixelrep, vmode_out.hdmitx_pixr_ifr, vmode_out.vic, pclk_o_hz);
+                            sii1136_init_mode(&siitx_dev, vmode_out.tx_pixelrep, vmode_out.hdmitx_pixr_ifr, vmode_out.vic, pclk_o_hz);
 #endif
+                        }
                     }
                 } else if (status & SC_CONFIG_CHANGE) {
                     update_sc_config(&vmode_in, &vmode_out, &vm_conf, cur_avconfig);
@@ -1313,14 +2375,30 @@ void mainloop()
 
             }
 
-            isl_update_config(&isl_dev, &cur_avconfig->isl_cfg, 0);
+            // driver keeps last applied config in isl_dev.cfg, so skip the call (and its I2C traffic) when nothing changed
+            if (isl_cfg_force || memcmp(&isl_dev.cfg, &cur_avconfig->isl_cfg, sizeof(isl51002_config))) {
+                isl_update_config(&isl_dev, &cur_avconfig->isl_cfg, 0);
+                isl_cfg_force = 0;
+            }
         }
 
 #ifdef INC_ADV7513
-        adv7513_check_hpd_power(&advtx_dev);
+        sys_status = hal_pio_rd(PIO_2_BASE);
+        if (!(sys_status & (1<<SSTAT_HDMITX_INT_N_BIT)) || (++hpd_poll_ctr >= HPD_POLL_INTERVAL)) {
+            adv7513_check_hpd_power(&advtx_dev);
+            hpd_poll_ctr = 0;
+        }
         if (advtx_dev.powered_on && (cur_avconfig->hdmitx_cfg.i2s_fs != advtx_dev.cfg.i2s_fs))
-            si5351_set_frac_mult(&si_dev, SI_PLLB, SI_CLK2, SI_XTAL, 0, 0, 0, (cur_avconfig->hdmitx_cfg.i2s_fs == IEC60958_FS_96KHZ) ? &si_audio_mclk_96k_conf : &si_audio_mclk_48k_conf);
-        adv7513_update_config(&advtx_dev, &cur_avconfig->hdmitx_cfg);
+            set_audio_mclk(cur_avconfig->hdmitx_cfg.i2s_fs == IEC60958_FS_96KHZ);
+        if ((advtx_dev.powered_on != advtx_powered_on_prev) || memcmp(&advtx_dev.cfg, &cur_avconfig->hdmitx_cfg, sizeof(advtx_dev.cfg))) {
+            adv7513_update_config(&advtx_dev, &cur_avconfig->hdmitx_cfg);
+            hdmi_game_applied = 0xff;
+        }
+        advtx_powered_on_prev = advtx_dev.powered_on;
+        if (advtx_dev.powered_on && (hdmi_game_mode != hdmi_game_applied)) {
+            adv7513_set_game_mode(&advtx_dev, hdmi_game_mode);
+            hdmi_game_applied = hdmi_game_mode;
+        }
 #endif
 #ifdef INC_SII1136
         sii1136_update_config(&siitx_dev, &cur_avconfig->hdmitx_cfg);
@@ -1328,11 +2406,17 @@ void mainloop()
 
         if (setup_rc_flag) {
             osd->osd_config.menu_active = 1;
+#ifdef CTRL_EVENT_FIFO_0_BASE
+            ctrl_events_override(0);
+            setup_rc_ret = setup_rc();
+            ctrl_events_override(1);
+#else
             setup_rc_ret = setup_rc();
+#endif
             sniprintf(menu_row1, US2066_ROW_LEN+1, (setup_rc_ret == 0) ? "Done" : "Default map set");
             menu_row2[0] = 0;
             ui_disp_menu(1);
-            usleep(800000);
+            hal_usleep(800000);
             osd->osd_config.menu_active = 0;
             read_controls();
             setup_rc_flag = 0;
@@ -1342,8 +2426,88 @@ void mainloop()
         if (vip_wdog_update())
             update_sc_config(&vmode_in, &vmode_out, &vm_conf, cur_avconfig);
 #endif
+        if (sd_hotplug_update() && (enable_tp || (enable_isl && isl_dev.sync_active)))
+            update_sc_config(&vmode_in, &vmode_out, &vm_conf, cur_avconfig);
+
+#ifdef FB_CAPTURE_DDR_WINDOW
+        if (fb_capture_req) {
+            strlcpy(row1, "Capturing frame", US2066_ROW_LEN+1);
+            row2[0] = 0;
+            ui_disp_status(1);
+            fb_capture_ret = vip_capture_frame(vmode_in.timings.h_active, vmode_in.timings.v_active<<vmode_in.timings.interlaced);
+            TRACE1(FB_CAPTURE, fb_capture_ret);
+            if (fb_capture_ret == FB_CAPTURE_OK)
+                strlcpy(row1, "Capture saved", US2066_ROW_LEN+1);
+            else {
+                strlcpy(row1, "Capture failed", US2066_ROW_LEN+1);
+                row2[0] = 0;
+            }
+            ui_disp_status(1);
+            fb_capture_req = 0;
+        }
+#endif
+#ifdef FW_UPDATE_BOARD_ID
+        if (fw_update_req) {
+            strlcpy(row1, "Updating flash", US2066_ROW_LEN+1);
+            strlcpy(row2, "Checking image", US2066_ROW_LEN+1);
+            ui_disp_status(1);
+            fw_update_pct = 0xff;
+            fw_update_ret = fw_update_run(fw_update_progress, &fw_update_stats);
+            TRACE4(FW_UPDATE, fw_update_ret, fw_update_stats.units_erased, fw_update_stats.units_programmed, fw_update_stats.units_unchanged);
+            if (fw_update_ret == FW_UPDATE_OK) {
+                strlcpy(row1, "Update done", US2066_ROW_LEN+1);
+                strlcpy(row2, "Power-cycle now", US2066_ROW_LEN+1);
+            } else {
+                strlcpy(row1, "Update failed", US2066_ROW_LEN+1);
+                sniprintf(row2, US2066_ROW_LEN+1, "Error %d", fw_update_ret);
+            }
+            printf("FW update: %d (%lu erased, %lu programmed, %lu unchanged, %lu retried)\n", fw_update_ret, fw_update_stats.units_erased,
+                   fw_update_stats.units_programmed, fw_update_stats.units_unchanged, fw_update_stats.pages_retried);
+            ui_disp_status(1);
+            fw_update_req = 0;
+        }
+#endif
+
+        sys_status = hal_pio_rd(PIO_2_BASE);
+        if (stress_mode != ((sys_ctrl & SCTRL_STRESS_MODE_MASK) >> SCTRL_STRESS_MODE_OFFS)) {
+            sys_ctrl = (sys_ctrl & ~SCTRL_STRESS_MODE_MASK) | ((uint32_t)stress_mode << SCTRL_STRESS_MODE_OFFS);
+            hal_pio_wr(PIO_0_BASE, sys_ctrl);
+            update_vip_err_counters(sys_status, 1);
+        } else {
+            update_vip_err_counters(sys_status, 0);
+        }
+        if (lm_prefetch_dist != ((sys_ctrl & SCTRL_LM_PREFETCH_MASK) >> SCTRL_LM_PREFETCH_OFFS)) {
+            sys_ctrl = (sys_ctrl & ~SCTRL_LM_PREFETCH_MASK) | ((uint32_t)(lm_prefetch_dist & 0x7) << SCTRL_LM_PREFETCH_OFFS);
+            hal_pio_wr(PIO_0_BASE, sys_ctrl);
+        }
+        if (frame_mult_bfi_lit_frames(cur_avconfig) != ((sys_ctrl & SCTRL_BFI_LIT_MASK) >> SCTRL_BFI_LIT_OFFS)) {
+            sys_ctrl = (sys_ctrl & ~SCTRL_BFI_LIT_MASK) | ((uint32_t)frame_mult_bfi_lit_frames(cur_avconfig) << SCTRL_BFI_LIT_OFFS);
+            hal_pio_wr(PIO_0_BASE, sys_ctrl);
+        }
 
-        while (alt_timestamp() < start_ts + MAINLOOP_INTERVAL_US*(TIMER_0_FREQ/1000000)) {}
+        if (++i2c_stats_ctr == I2C_STATS_INTERVAL) {
+            i2c_stats_update_period();
+            if (stress_mode)
+                printf("stress %u: %s -> %s, cvi ovf %lu, cvo udf %lu\n", stress_mode, vmode_in.name, vmode_out.name, vip_cvi_overflows, vip_cvo_underflows);
+#ifdef EMIF_PERF_MON
+            if (emif_perf_update()) {
+                TRACE4(EMIF_PERF, emif_perf.rd_mbps, emif_perf.wr_mbps, emif_perf.rd_lat_avg_ns, emif_perf.rd_lat_max_ns);
+                if (stress_mode)
+                    printf("emif: rd %luMB/s lat %lu/%luns stall %lu.%lu%%, wr %luMB/s\n", emif_perf.rd_mbps, emif_perf.rd_lat_avg_ns, emif_perf.rd_lat_max_ns,
+                           emif_perf.rd_stall_permille/10, emif_perf.rd_stall_permille%10, emif_perf.wr_mbps);
+            }
+#endif
+            i2c_stats_ctr = 0;
+        }
+
+        if (hal_timestamp() > start_ts + hal_us_to_ticks(MAINLOOP_INTERVAL_US)) {
+            mainloop_overruns++;
+            TRACE1(MAINLOOP_OVERRUN, (uint32_t)((hal_timestamp() - start_ts) / hal_us_to_ticks(1)));
+        }
+
+        // idle time is used for sending trace records to host
+        while (hal_timestamp() < start_ts + hal_us_to_ticks(MAINLOOP_INTERVAL_US))
+            trace_drain();
     }
 }
 
@@ -1352,7 +2516,10 @@ int main()
     int ret;
 
     // Start system clock
-    alt_timestamp_start();
+    hal_init();
+
+    trace_init();
+    TRACE3(INIT, HAL_TIMESTAMP_FREQ, FW_VER_MAJOR, FW_VER_MINOR);
 
     while (1) {
         ret = init_hw();
@@ -1371,7 +2538,7 @@ int main()
         // Powerup
         sys_ctrl |= SCTRL_POWER_ON;
         sys_ctrl &= ~SCTRL_EMIF_POWERDN_REQ;
-        IOWR_ALTERA_AVALON_PIO_DATA(PIO_0_BASE, sys_ctrl);
+        hal_pio_wr(PIO_0_BASE, sys_ctrl);
 
         // Invalidate input
         avinput = (avinput_t)-1;
@@ -1382,6 +2549,10 @@ int main()
         sii1136_enable_power(&siitx_dev, 1);
 #endif
 
+#ifdef CTRL_EVENT_FIFO_0_BASE
+        ctrl_events_init();
+#endif
+
         mainloop();
     }
 }
@@ -0,0 +1,127 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include "trace.h"
+#include "hal.h"
+#if !defined(HAL_HPS) && !defined(HAL_HOST)
+#include "sys/alt_irq.h"
+#define TRACE_IRQ_SAVE(ctx)     ctx = alt_irq_disable_all()
+#define TRACE_IRQ_RESTORE(ctx)  alt_irq_enable_all(ctx)
+#else
+#define TRACE_IRQ_SAVE(ctx)     (void)ctx
+#define TRACE_IRQ_RESTORE(ctx)
+#endif
+
+#ifndef TRACE_DISABLE
+
+#if (TRACE_RING_WORDS & (TRACE_RING_WORDS-1))
+#error TRACE_RING_WORDS must be a power of two
+#endif
+
+// drain keeps running this many calls after last host activity
+#define TRACE_HOST_TIMEOUT      1000
+
+static uint32_t ring[TRACE_RING_WORDS];
+static volatile uint32_t ring_wr, ring_rd;
+static uint8_t seq;
+static uint32_t lost;
+static uint16_t host_active;
+
+#define RING_USED()             ((ring_wr - ring_rd) & (TRACE_RING_WORDS-1))
+
+void trace_init() {
+    ring_wr = ring_rd = 0;
+    seq = 0;
+    lost = 0;
+    host_active = 0;
+}
+
+void trace_emit(trace_id_t id, int nargs, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3) {
+    uint32_t ctx, wr, len = 2 + nargs;
+
+    // reservation is the only critical section; single core, so masking interrupts suffices
+    TRACE_IRQ_SAVE(ctx);
+    while (RING_USED() + len >= TRACE_RING_WORDS) {
+        ring_rd = (ring_rd + 2 + TRACE_HDR_NARGS(ring[ring_rd])) & (TRACE_RING_WORDS-1);
+        lost++;
+    }
+    wr = ring_wr;
+    ring[wr] = TRACE_HDR(id, nargs, seq++);
+    ring[(wr+1) & (TRACE_RING_WORDS-1)] = (uint32_t)hal_timestamp();
+    if (nargs > 0)
+        ring[(wr+2) & (TRACE_RING_WORDS-1)] = a0;
+    if (nargs > 1)
+        ring[(wr+3) & (TRACE_RING_WORDS-1)] = a1;
+    if (nargs > 2)
+        ring[(wr+4) & (TRACE_RING_WORDS-1)] = a2;
+    if (nargs > 3)
+        ring[(wr+5) & (TRACE_RING_WORDS-1)] = a3;
+    ring_wr = (wr + len) & (TRACE_RING_WORDS-1);
+    TRACE_IRQ_RESTORE(ctx);
+}
+
+void trace_drain() {
+#ifdef JTAG_UART_0_BASE
+    uint32_t ctrl, ctx, rd, len, wspace, i, w;
+
+    ctrl = IORD(JTAG_UART_0_BASE, JUART_CONTROL);
+    if (ctrl & JUART_CONTROL_AC) {
+        IOWR(JTAG_UART_0_BASE, JUART_CONTROL, JUART_CONTROL_AC);
+        host_active = TRACE_HOST_TIMEOUT;
+    } else if (host_active) {
+        host_active--;
+    }
+    if (!host_active)
+        return;
+
+    wspace = ctrl >> JUART_CONTROL_WSPACE_OFFS;
+
+    while (1) {
+        // whole records only, so that printf output cannot land inside a record
+        TRACE_IRQ_SAVE(ctx);
+        if (ring_rd == ring_wr) {
+            TRACE_IRQ_RESTORE(ctx);
+            break;
+        }
+        rd = ring_rd;
+        len = 2 + TRACE_HDR_NARGS(ring[rd]);
+        if (4*len > wspace) {
+            TRACE_IRQ_RESTORE(ctx);
+            break;
+        }
+        for (i=0; i<len; i++) {
+            w = ring[(rd+i) & (TRACE_RING_WORDS-1)];
+            IOWR(JTAG_UART_0_BASE, JUART_DATA, w & 0xff);
+            IOWR(JTAG_UART_0_BASE, JUART_DATA, (w >> 8) & 0xff);
+            IOWR(JTAG_UART_0_BASE, JUART_DATA, (w >> 16) & 0xff);
+            IOWR(JTAG_UART_0_BASE, JUART_DATA, w >> 24);
+        }
+        ring_rd = (rd + len) & (TRACE_RING_WORDS-1);
+        TRACE_IRQ_RESTORE(ctx);
+        wspace -= 4*len;
+    }
+#endif
+}
+
+uint32_t trace_lost_records() {
+    return lost;
+}
+
+#endif
@@ -0,0 +1,64 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <stdint.h>
+#include "trace_ids.h"
+
+// Binary trace records are written to a RAM ring buffer and sent to JTAG UART only while a
+// host reader (nios2-terminal) is attached, so tracing costs a few dozen instructions per
+// record and never blocks. Oldest records are overwritten when the ring is full; host detects
+// the gap from sequence numbers. Define TRACE_DISABLE to compile out.
+#ifndef TRACE_RING_WORDS
+#define TRACE_RING_WORDS    1024
+#endif
+
+#ifndef TRACE_DISABLE
+
+void trace_init();
+void trace_emit(trace_id_t id, int nargs, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3);
+
+// Sends complete records to JTAG UART while its FIFO has space. Called from main loop idle time.
+void trace_drain();
+
+uint32_t trace_lost_records();
+
+#define TRACE0(id)                  trace_emit(TRACE_ ## id, 0, 0, 0, 0, 0)
+#define TRACE1(id, a0)              trace_emit(TRACE_ ## id, 1, (uint32_t)(a0), 0, 0, 0)
+#define TRACE2(id, a0, a1)          trace_emit(TRACE_ ## id, 2, (uint32_t)(a0), (uint32_t)(a1), 0, 0)
+#define TRACE3(id, a0, a1, a2)      trace_emit(TRACE_ ## id, 3, (uint32_t)(a0), (uint32_t)(a1), (uint32_t)(a2), 0)
+#define TRACE4(id, a0, a1, a2, a3)  trace_emit(TRACE_ ## id, 4, (uint32_t)(a0), (uint32_t)(a1), (uint32_t)(a2), (uint32_t)(a3))
+
+#else
+
+#define trace_init()
+#define trace_drain()
+#define trace_lost_records()        0
+#define TRACE0(id)
+#define TRACE1(id, a0)
+#define TRACE2(id, a0, a1)
+#define TRACE3(id, a0, a1, a2)
+#define TRACE4(id, a0, a1, a2, a3)
+
+#endif
+
+#endif /* TRACE_H_ */
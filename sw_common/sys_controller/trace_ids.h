@@ -0,0 +1,67 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef TRACE_IDS_H_
+#define TRACE_IDS_H_
+
+// Trace event list shared by firmware and host decoder (sw_common/trace_decode).
+// X(name, argument format). Arguments are 32-bit unsigned values unless the format says otherwise.
+// New events are appended to keep IDs of existing ones stable.
+#define TRACE_EVENT_LIST(X) \
+    X(INIT,             "ts_freq=%lu fw=%lu.%.2lu") \
+    X(MAINLOOP_OVERRUN, "elapsed_us=%lu") \
+    X(INPUT_SWITCH,     "avinput=%lu") \
+    X(SYNC_UP,          "") \
+    X(SYNC_LOST,        "") \
+    X(MODE_CHANGE,      "v_total=%lu interlaced=%lu opermode=%ld pclk_o=%lu") \
+    X(SC_CONFIG,        "h_active=%lu v_active=%lu") \
+    X(VIP_WDOG_RESET,   "resets=%lu") \
+    X(VIP_ERR,          "cvi_ovf=%lu cvo_udf=%lu") \
+    X(SD_STATE,         "state=%lu") \
+    X(FB_CAPTURE,       "status=%ld") \
+    X(CTRL_EVENT,       "evt=0x%.8lx ts_us=%lu") \
+    X(I2C_NACK,         "base=0x%.8lx addr=0x%.2lx") \
+    X(FW_UPDATE,        "status=%ld erased=%lu programmed=%lu unchanged=%lu") \
+    X(VIP_STALL,        "cores=0x%lx stalls=0x%.8lx") \
+    X(OUT_HOLD,         "pclk_o=%lu") \
+    X(CMD_REPLY,        "seq_cmd_status=0x%.6lx d0=0x%.8lx d1=0x%.8lx d2=0x%.8lx") \
+    X(EMIF_PERF,        "rd_mbps=%lu wr_mbps=%lu lat_avg_ns=%lu lat_max_ns=%lu") \
+    X(PCLK_RATIO,       "err_ppt=%ld resync_s=%lu")
+
+#define TRACE_ENUM(name, fmt) TRACE_ ## name,
+typedef enum {
+    TRACE_EVENT_LIST(TRACE_ENUM)
+    TRACE_NUM_EVENTS
+} trace_id_t;
+#undef TRACE_ENUM
+
+// Record layout (little-endian 32-bit words, sent as-is to host):
+//   word 0: [7:0] sync byte, [15:8] ID, [23:16] number of args, [31:24] sequence number
+//   word 1: timestamp (lower 32 bits of hal_timestamp())
+//   word 2..: args
+// Sync byte never occurs in printf text sharing the same JTAG UART.
+#define TRACE_SYNC_BYTE     0xA5
+#define TRACE_MAX_ARGS      4
+#define TRACE_HDR(id, n, seq)   (TRACE_SYNC_BYTE | ((uint32_t)(id) << 8) | ((uint32_t)(n) << 16) | ((uint32_t)(seq) << 24))
+#define TRACE_HDR_ID(hdr)       (((hdr) >> 8) & 0xff)
+#define TRACE_HDR_NARGS(hdr)    (((hdr) >> 16) & 0xff)
+#define TRACE_HDR_SEQ(hdr)      (((hdr) >> 24) & 0xff)
+
+#endif /* TRACE_IDS_H_ */
@@ -0,0 +1,178 @@
+//
+// Copyright (C) 2024  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+// Host-side decoder for firmware trace records (see sys_controller/trace.h). Reads the JTAG UART
+// byte stream (e.g. piped from nios2-terminal) or a capture file, passes printf text through and
+// prints trace records as a timeline with absolute and delta times. Timestamp frequency is taken
+// from the INIT record, or from -f when capture starts after it.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "trace_ids.h"
+
+#define TRACE_NAME(name, fmt) #name,
+#define TRACE_FMT(name, fmt) fmt,
+static const char *trace_names[] = { TRACE_EVENT_LIST(TRACE_NAME) };
+static const char *trace_fmts[] = { TRACE_EVENT_LIST(TRACE_FMT) };
+
+static uint64_t ts_freq;
+static uint64_t ts_ext, ts_first, ts_prev;
+static uint32_t ts_last;
+static int have_ts;
+static int seq_valid;
+static uint8_t seq_next;
+static unsigned long lost;
+
+static uint32_t rd_le32(const uint8_t *b) {
+    return b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+static double ticks_to_ms(uint64_t ticks) {
+    return ts_freq ? (1000.0*ticks)/ts_freq : (double)ticks;
+}
+
+// sign-extend arguments printed with %ld
+static int arg_is_signed(unsigned id, unsigned argn) {
+    const char *p;
+    unsigned n = 0;
+
+    if (id >= TRACE_NUM_EVENTS)
+        return 0;
+
+    for (p = trace_fmts[id]; *p; p++) {
+        if (*p != '%')
+            continue;
+        p += strcspn(p, "diouxXc");
+        if (!*p)
+            break;
+        if (n++ == argn)
+            return (*p == 'd') || (*p == 'i');
+    }
+    return 0;
+}
+
+static void print_record(uint32_t hdr, uint32_t ts, const uint32_t *args) {
+    unsigned id = TRACE_HDR_ID(hdr);
+    unsigned nargs = TRACE_HDR_NARGS(hdr);
+    uint8_t seq = TRACE_HDR_SEQ(hdr);
+    unsigned long a[TRACE_MAX_ARGS] = {0};
+    unsigned i;
+
+    if (seq_valid && (seq != seq_next)) {
+        lost += (uint8_t)(seq - seq_next);
+        printf("%16s  %12s  <%u records lost>\n", "", "", (uint8_t)(seq - seq_next));
+    }
+    seq_next = seq + 1;
+    seq_valid = 1;
+
+    if ((id == TRACE_INIT) && (nargs > 0)) {
+        ts_freq = args[0];
+        have_ts = 0;
+    }
+
+    // unwrap 32-bit timestamp, records are in order
+    if (!have_ts) {
+        ts_ext = ts;
+        ts_first = ts_prev = ts_ext;
+        have_ts = 1;
+    } else {
+        ts_ext += (uint32_t)(ts - ts_last);
+    }
+    ts_last = ts;
+
+    for (i=0; (i<nargs) && (i<TRACE_MAX_ARGS); i++)
+        a[i] = arg_is_signed(id, i) ? (unsigned long)(long)(int32_t)args[i] : args[i];
+
+    printf("%16.6f  %+12.6f  %-18s ", ticks_to_ms(ts_ext-ts_first), ticks_to_ms(ts_ext-ts_prev), (id < TRACE_NUM_EVENTS) ? trace_names[id] : "UNKNOWN");
+    if (id < TRACE_NUM_EVENTS)
+        printf(trace_fmts[id], a[0], a[1], a[2], a[3]);
+    else
+        printf("id=%u args=0x%.8lx 0x%.8lx 0x%.8lx 0x%.8lx", id, a[0], a[1], a[2], a[3]);
+    printf("\n");
+
+    ts_prev = ts_ext;
+}
+
+int main(int argc, char **argv) {
+    FILE *in = stdin;
+    uint8_t buf[8+4*TRACE_MAX_ARGS];
+    uint32_t args[TRACE_MAX_ARGS];
+    unsigned fill = 0, need, i;
+    int c, text_bol = 1;
+
+    for (i=1; i<(unsigned)argc; i++) {
+        if (!strcmp(argv[i], "-f") && (i+1 < (unsigned)argc)) {
+            ts_freq = strtoull(argv[++i], NULL, 0);
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "usage: %s [-f ts_freq_hz] [capture_file]\n", argv[0]);
+            return 1;
+        } else if ((in = fopen(argv[i], "rb")) == NULL) {
+            perror(argv[i]);
+            return 1;
+        }
+    }
+
+    printf("%16s  %12s  %-18s %s\n", "time_ms", "delta_ms", "event", "args");
+
+    while ((c = fgetc(in)) != EOF) {
+        if (fill == 0) {
+            if (c != TRACE_SYNC_BYTE) {
+                // printf output
+                if (text_bol)
+                    printf("%16s  %12s  # ", "", "");
+                putchar(c);
+                text_bol = (c == '\n');
+                continue;
+            }
+            if (!text_bol) {
+                putchar('\n');
+                text_bol = 1;
+            }
+        }
+        buf[fill++] = c;
+
+        if (fill < 4)
+            continue;
+        if (TRACE_HDR_NARGS(rd_le32(buf)) > TRACE_MAX_ARGS) {
+            // false sync, drop it
+            fill = 0;
+            continue;
+        }
+        need = 8 + 4*TRACE_HDR_NARGS(rd_le32(buf));
+        if (fill < need)
+            continue;
+
+        for (i=0; i<TRACE_HDR_NARGS(rd_le32(buf)); i++)
+            args[i] = rd_le32(buf+8+4*i);
+        print_record(rd_le32(buf), rd_le32(buf+4), args);
+        fflush(stdout);
+        fill = 0;
+    }
+
+    if (lost)
+        printf("# %lu records lost in total\n", lost);
+
+    if (in != stdin)
+        fclose(in);
+
+    return 0;
+}